@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+// Synthetic 640x480 @ 60 Hz VGA signals with 3 bit per color, one sample per pixel clock
+// for one complete frame of 800 x 525 pixel clocks, starting with both sync pulses.
+class CVgaSignalGenerator
+{
+    public:
+        // types
+        enum class Pattern
+        {
+            STATIC_COLOR,   // a single color in the whole active area
+            BARS,           // red, green and blue vertical bars
+            CHESSBOARD,     // 16 x 16 pixel black and white squares
+            NOISE,          // random colors
+            MISTIMED        // bars with a short hsync pulse, 3 vsync lines and colors in the porches
+        };
+
+        struct Sample
+        {
+            bool hSync;
+            bool vSync;
+            uint8_t red;
+            uint8_t green;
+            uint8_t blue;
+        };
+
+        static constexpr size_t hTotal = 800;
+        static constexpr size_t vTotal = 525;
+
+        // methods
+        static std::vector<Sample> generateFrame(Pattern pattern)
+        {
+            bool mistimed = (pattern == Pattern::MISTIMED);
+            size_t hSyncPulse = mistimed ? 88 : 96;
+            size_t vSyncPulse = mistimed ? 3 : 2;
+            uint32_t noise = 0x12345678;
+
+            std::vector<Sample> frame;
+            frame.reserve(hTotal * vTotal);
+            for (size_t v = 0; v < vTotal; ++v)
+            {
+                for (size_t h = 0; h < hTotal; ++h)
+                {
+                    Sample sample { h >= hSyncPulse, v >= vSyncPulse, 0, 0, 0 };
+
+                    bool hActive = (h >= 144) && (h < (mistimed ? hTotal : 784));
+                    bool vActive = (v >= 35) && (v < 515);
+                    if (hActive && vActive)
+                    {
+                        size_t x = h - 144;
+                        size_t y = v - 35;
+                        uint8_t color = 0;
+
+                        switch (pattern)
+                        {
+                            case Pattern::STATIC_COLOR:
+                                sample.red = 5;
+                                sample.green = 2;
+                                sample.blue = 7;
+                                break;
+
+                            case Pattern::BARS:
+                            case Pattern::MISTIMED:
+                                sample.red = (x < 213) ? 7 : 0;
+                                sample.green = ((x >= 213) && (x <= 427)) ? 7 : 0;
+                                sample.blue = (x > 427) ? 7 : 0;
+                                break;
+
+                            case Pattern::CHESSBOARD:
+                                color = (((x >> 4) ^ (y >> 4)) & 1) ? 7 : 0;
+                                sample.red = color;
+                                sample.green = color;
+                                sample.blue = color;
+                                break;
+
+                            case Pattern::NOISE:
+                                // xorshift32
+                                noise ^= noise << 13;
+                                noise ^= noise >> 17;
+                                noise ^= noise << 5;
+                                sample.red = noise & 7;
+                                sample.green = (noise >> 3) & 7;
+                                sample.blue = (noise >> 6) & 7;
+                                break;
+                        }
+                    }
+
+                    frame.push_back(sample);
+                }
+            }
+
+            return frame;
+        }
+};
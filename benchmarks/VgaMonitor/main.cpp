@@ -0,0 +1,237 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "CVgaMonitor.hpp"
+#include "CVgaSignalGenerator.hpp"
+
+// Microbenchmarks of the monitor hot paths, fed with synthetic signals so that they measure
+// the monitor alone. Every path reports the time per sample and the sample rate; eval takes
+// two samples per pixel, clockPixel one.
+//
+// usage: vga_monitor_microbench [--frames N]
+
+using namespace std::chrono_literals;
+
+using Clock = std::chrono::steady_clock;
+using Pattern = CVgaSignalGenerator::Pattern;
+using CheckPolicy = CVgaMonitor::CheckPolicy;
+
+// keeps the compiler from dropping computations whose results are otherwise unused
+volatile uint64_t sink = 0;
+
+void report(const std::string &path, const std::string &mode, size_t samples, Clock::duration time)
+{
+    double seconds = std::chrono::duration<double>(time).count();
+    std::cout << std::left << std::setw(24) << path << std::setw(34) << mode << std::right
+        << std::fixed << std::setprecision(2) << std::setw(10) << seconds * 1.0e9 / samples
+        << " ns/sample" << std::setw(12) << samples / seconds / 1.0e6 << " Msamples/s"
+        << std::endl;
+}
+
+std::string toString(Pattern pattern)
+{
+    switch (pattern)
+    {
+        case Pattern::STATIC_COLOR: return "static color";
+        case Pattern::BARS: return "bars";
+        case Pattern::CHESSBOARD: return "chessboard";
+        case Pattern::NOISE: return "noise";
+        case Pattern::MISTIMED: return "mistimed";
+    }
+    return "";
+}
+
+std::string toString(CheckPolicy policy)
+{
+    switch (policy)
+    {
+        case CheckPolicy::OFF: return "off";
+        case CheckPolicy::SYNC_ONLY: return "sync only";
+        case CheckPolicy::FULL: return "full";
+        case CheckPolicy::FULL_WITH_STATISTICS: return "full with statistics";
+    }
+    return "";
+}
+
+// CVgaMonitor::eval as called by the example, twice per pixel clock of 40 ns
+void benchmarkEval(const std::vector<CVgaSignalGenerator::Sample> &frame, Pattern pattern,
+        CheckPolicy policy, bool strict, size_t frames)
+{
+    CVgaMonitor monitor { policy };
+    monitor.setup(CVgaMonitor::Mode::VGA_640x480_60Hz, CVgaMonitor::ColorDepth::RGB_3BitPerColor,
+            CVgaMonitor::Display::HEADLESS);
+    monitor.setTimingTolerance(0.0075);
+
+    size_t violations = 0;
+    if (strict)
+    {
+        monitor.setStrictMode(std::numeric_limits<size_t>::max(), 0,
+                [&](const CVgaMonitor::TimingViolation &) { ++violations; });
+    }
+
+    auto start = Clock::now();
+    for (size_t n = 0; n < frames; ++n)
+    {
+        for (const auto &s : frame)
+        {
+            monitor.eval(s.hSync, s.vSync, s.red, s.green, s.blue, 20ns);
+            monitor.eval(s.hSync, s.vSync, s.red, s.green, s.blue, 20ns);
+        }
+    }
+    auto time = Clock::now() - start;
+    sink = sink + violations + monitor.getFrameCount();
+
+    auto path = (policy == CheckPolicy::OFF) ? "eval (pixel placement)" : "eval";
+    report(path, toString(pattern) + ", " + toString(policy) + (strict ? ", strict" : ""),
+            2 * frames * frame.size(), time);
+}
+
+// CVgaMonitor::clockPixel, once per pixel clock
+void benchmarkClockPixel(const std::vector<CVgaSignalGenerator::Sample> &frame, Pattern pattern,
+        CheckPolicy policy, size_t frames)
+{
+    CVgaMonitor monitor { policy };
+    monitor.setup(CVgaMonitor::Mode::VGA_640x480_60Hz, CVgaMonitor::ColorDepth::RGB_3BitPerColor,
+            CVgaMonitor::Display::HEADLESS);
+    monitor.setTimingTolerance(0.0075);
+
+    auto start = Clock::now();
+    for (size_t n = 0; n < frames; ++n)
+    {
+        for (const auto &s : frame)
+        {
+            monitor.clockPixel(s.hSync, s.vSync, s.red, s.green, s.blue);
+        }
+    }
+    auto time = Clock::now() - start;
+    sink = sink + monitor.getFrameCount();
+
+    report("clockPixel", toString(pattern) + ", " + toString(policy), frames * frame.size(), time);
+}
+
+// the timing check alone, with the line timing of 640x480 @ 60 Hz
+template <bool checkColors>
+void benchmarkCheckSignalTiming(const std::vector<CVgaSignalGenerator::Sample> &frame,
+        size_t frames)
+{
+    constexpr auto pixel = 40ns;
+
+    auto start = Clock::now();
+    uint64_t timingInfo = 0;
+    for (size_t n = 0; n < frames; ++n)
+    {
+        for (size_t i = 0; i < frame.size(); ++i)
+        {
+            const auto &s = frame[i];
+            bool isBlack = (s.red == 0) && (s.green == 0) && (s.blue == 0);
+            auto t = (i % CVgaSignalGenerator::hTotal) * pixel;
+            timingInfo += CVgaMonitor::checkSignalTiming<checkColors>(s.hSync, isBlack, t,
+                    96 * pixel, 48 * pixel, 640 * pixel, 16 * pixel, 0.0075);
+        }
+    }
+    auto time = Clock::now() - start;
+    sink = sink + timingInfo;
+
+    report("checkSignalTiming", checkColors ? "sync and colors" : "sync only",
+            frames * frame.size(), time);
+}
+
+// the timing check of pixel clocked sampling alone
+template <bool checkColors>
+void benchmarkCheckPixelTiming(const std::vector<CVgaSignalGenerator::Sample> &frame,
+        size_t frames)
+{
+    auto ranges = CVgaMonitor::getPhaseRanges(96, 48, 640, 16, 0.0075);
+
+    auto start = Clock::now();
+    uint64_t timingInfo = 0;
+    for (size_t n = 0; n < frames; ++n)
+    {
+        for (size_t i = 0; i < frame.size(); ++i)
+        {
+            const auto &s = frame[i];
+            bool isBlack = (s.red == 0) && (s.green == 0) && (s.blue == 0);
+            timingInfo += CVgaMonitor::checkPixelTiming<checkColors>(s.hSync, isBlack,
+                    i % CVgaSignalGenerator::hTotal, ranges);
+        }
+    }
+    auto time = Clock::now() - start;
+    sink = sink + timingInfo;
+
+    report("checkPixelTiming", checkColors ? "sync and colors" : "sync only",
+            frames * frame.size(), time);
+}
+
+// conversion of the frame buffer into packed rgb pixels
+void benchmarkCopyFrame(const std::vector<CVgaSignalGenerator::Sample> &frame, size_t frames)
+{
+    CVgaMonitor monitor { CheckPolicy::OFF };
+    monitor.setup(CVgaMonitor::Mode::VGA_640x480_60Hz, CVgaMonitor::ColorDepth::RGB_3BitPerColor,
+            CVgaMonitor::Display::HEADLESS);
+    for (const auto &s : frame)
+    {
+        monitor.eval(s.hSync, s.vSync, s.red, s.green, s.blue, 40ns);
+    }
+
+    std::vector<uint32_t> rgb;
+    auto start = Clock::now();
+    for (size_t n = 0; n < frames; ++n)
+    {
+        monitor.copyFrame(rgb);
+        sink = sink + rgb[n % rgb.size()];
+    }
+    auto time = Clock::now() - start;
+
+    report("copyFrame", "per pixel", frames * monitor.getWidth() * monitor.getHeight(), time);
+}
+
+int main(int argc, char **argv)
+{
+    size_t frames = 20;
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((std::string { argv[i] } == "--frames") && (i + 1 < argc))
+        {
+            frames = std::stoul(argv[++i]);
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--frames N]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const Pattern patterns[] = {
+        Pattern::STATIC_COLOR, Pattern::BARS, Pattern::CHESSBOARD, Pattern::NOISE,
+        Pattern::MISTIMED
+    };
+    const CheckPolicy policies[] = {
+        CheckPolicy::OFF, CheckPolicy::SYNC_ONLY, CheckPolicy::FULL,
+        CheckPolicy::FULL_WITH_STATISTICS
+    };
+
+    for (auto pattern : patterns)
+    {
+        auto frame = CVgaSignalGenerator::generateFrame(pattern);
+        for (auto policy : policies)
+        {
+            benchmarkEval(frame, pattern, policy, false, frames);
+            benchmarkClockPixel(frame, pattern, policy, frames);
+        }
+        benchmarkEval(frame, pattern, CheckPolicy::FULL, true, frames);
+    }
+
+    auto bars = CVgaSignalGenerator::generateFrame(Pattern::BARS);
+    benchmarkCheckSignalTiming<false>(bars, frames);
+    benchmarkCheckSignalTiming<true>(bars, frames);
+    benchmarkCheckPixelTiming<false>(bars, frames);
+    benchmarkCheckPixelTiming<true>(bars, frames);
+    benchmarkCopyFrame(bars, 10 * frames);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <verilated.h>
+#ifdef VGA_SAVABLE
+#include <verilated_save.h>
+#endif
+
+#include "CVgaMonitor.hpp"
+
+// Checkpoints of a simulation in a single file: the simulation time, the state of the model
+// verilated with --savable and the state of the monitor. A checkpoint is restored into the same
+// model and a monitor set up like the saved one, after which the simulation continues from the
+// saved frame instead of from reset.
+
+inline std::string getCheckpointFileName(const std::string &prefix, size_t frame)
+{
+    std::ostringstream fileName;
+    fileName << prefix << "_" << std::setw(5) << std::setfill('0') << frame << ".ckpt";
+    return fileName.str();
+}
+
+template <typename Model>
+inline bool saveCheckpoint(const std::string &fileName, const VerilatedContext &context,
+        Model &model, const CVgaMonitor &monitor)
+{
+#ifdef VGA_SAVABLE
+    std::vector<uint8_t> state;
+    monitor.saveState(state);
+    uint64_t time = context.time();
+    uint64_t size = state.size();
+
+    VerilatedSave os;
+    os.open(fileName.c_str());
+    if (!os.isOpen())
+    {
+        std::cerr << "could not open checkpoint file " << fileName << std::endl;
+        return false;
+    }
+    os.write(&time, sizeof(time));
+    os << model;
+    os.write(&size, sizeof(size));
+    os.write(state.data(), state.size());
+    os.close();
+
+    return true;
+#else
+    std::cerr << "checkpoints need models verilated with --savable (VGA_SAVABLE)" << std::endl;
+    return false;
+#endif
+}
+
+template <typename Model>
+inline bool restoreCheckpoint(const std::string &fileName, VerilatedContext &context,
+        Model &model, CVgaMonitor &monitor)
+{
+#ifdef VGA_SAVABLE
+    uint64_t time = 0;
+    uint64_t size = 0;
+    std::vector<uint8_t> state;
+
+    VerilatedRestore os;
+    os.open(fileName.c_str());
+    if (!os.isOpen())
+    {
+        std::cerr << "could not open checkpoint file " << fileName << std::endl;
+        return false;
+    }
+    os.read(&time, sizeof(time));
+    os >> model;
+    os.read(&size, sizeof(size));
+    state.resize(size);
+    os.read(state.data(), state.size());
+    os.close();
+
+    context.time(time);
+    return monitor.restoreState(state);
+#else
+    std::cerr << "checkpoints need models verilated with --savable (VGA_SAVABLE)" << std::endl;
+    return false;
+#endif
+}
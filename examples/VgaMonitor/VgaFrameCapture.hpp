@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// writes a frame of 0x00RRGGBB pixels, as returned by CVgaMonitor::copyFrame, as binary PPM
+inline bool writePpm(const std::string &fileName, const std::vector<uint32_t> &frame,
+        size_t width, size_t height)
+{
+    std::ofstream file { fileName, std::ios::binary };
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for (auto pixel : frame)
+    {
+        char rgb[3] = {
+            static_cast<char>(pixel >> 16), static_cast<char>(pixel >> 8), static_cast<char>(pixel)
+        };
+        file.write(rgb, sizeof(rgb));
+    }
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CVgaMonitor.hpp"
+
+// Phases of the simulation loops for CPhaseProfiler. The monitor marks its own phases, which
+// start at SAMPLING in the order of CVgaMonitor::Phase.
+enum class SimPhase : uint8_t
+{
+    OTHER, EVAL, SAMPLING, TIMING_CHECK, FRAME, TRACING, PACING, PAUSED
+};
+
+constexpr uint8_t toMarker(SimPhase phase)
+{
+    return static_cast<uint8_t>(phase);
+}
+
+static_assert(toMarker(SimPhase::TIMING_CHECK) == toMarker(SimPhase::SAMPLING)
+        + static_cast<uint8_t>(CVgaMonitor::Phase::TIMING_CHECK), "monitor phases out of order");
+static_assert(toMarker(SimPhase::FRAME) == toMarker(SimPhase::SAMPLING)
+        + static_cast<uint8_t>(CVgaMonitor::Phase::FRAME), "monitor phases out of order");
+
+const std::vector<std::string> simPhaseNames {
+    "other", "verilator eval", "monitor sampling", "timing check", "frame/render", "tracing",
+    "pacing", "paused"
+};
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <verilated.h>
+#ifdef VGA_TRACE_FST
+#include <verilated_fst_c.h>
+#else
+#include <verilated_vcd_c.h>
+#endif
+
+#include "CClockScheduler.hpp"
+#include "CPhaseProfiler.hpp"
+#include "CPinTraceWriter.hpp"
+#include "CRunTraceWriter.hpp"
+#include "CSignalHistory.hpp"
+#include "CTraceControl.hpp"
+#include "CVgaMonitor.hpp"
+#include "CVgaMonitorPeripheral.hpp"
+#include "VVGA_top_chess.h"
+#include "VVGA_top_psychedelic.h"
+#include "VVGA_top_rgb.h"
+#include "VgaCheckpoint.hpp"
+#include "VgaFrameCapture.hpp"
+#include "VgaProfilePhases.hpp"
+#include "VgaRegression.hpp"
+#include "VgaTopSignals.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+#ifdef VGA_TRACE_FST
+using Tracer = VerilatedFstC;
+#else
+using Tracer = VerilatedVcdC;
+#endif
+
+const char *regressionUsage = "[--mode 640x480] [--pattern psychedelic|rgb|chess]"
+    " [--frames N] [--warmup N] [--tolerance T] [--check off|sync|full|stats] [--fail-fast]"
+    " [--trace FILE] [--trace-on-violation FILE] [--capture PREFIX] [--record FILE]"
+    " [--record-runs FILE] [--checkpoint PREFIX] [--checkpoint-every N] [--restore FILE]"
+    " [--profile] [--json]";
+
+template <typename Model>
+static bool run(const RegressionOptions &options, RegressionSummary &summary)
+{
+    VerilatedContext context;
+    context.threads(VGA_VERILATOR_THREADS);
+    auto tracing = !options.traceFile.empty() || !options.violationTraceFile.empty();
+    context.traceEverOn(tracing);
+    Model controller { &context };
+    controller.i_clk = 0;
+
+    // the pixel clock and time units of the interactive example, so checkpoints carry over
+    auto ticksPerSecond = getTicksPerSecond(context);
+    auto pixelPeriodPs = static_cast<uint32_t>(std::llround(1e12 / vgaPixelClockHz));
+
+    CVgaMonitor monitor { options.policy };
+    if (!monitor.setup(options.mode, CVgaMonitor::ColorDepth::RGB_3BitPerColor,
+            CVgaMonitor::Display::HEADLESS))
+    {
+        std::cerr << "Monitor setup failed" << std::endl;
+        return false;
+    }
+    monitor.setTimingTolerance(options.tolerance);
+
+    // hash and capture every complete frame, frame 0 is the one before the first vsync
+    std::vector<uint32_t> frame;
+    monitor.setFrameCallback([&](size_t index)
+        {
+            if ((index == 0) || (index > options.frames)) return;
+
+            summary.hashes.push_back(monitor.hashFrame());
+            if (!options.capturePrefix.empty())
+            {
+                monitor.copyFrame(frame);
+                std::ostringstream fileName;
+                fileName << options.capturePrefix << "_" << std::setw(5) << std::setfill('0')
+                    << index << ".ppm";
+                writePpm(fileName.str(), frame, monitor.getWidth(), monitor.getHeight());
+            }
+        });
+
+    Tracer tracer;
+    CTraceControl<Tracer> traceControl { tracer };
+    CSignalHistory history { pinNames, 65536 };
+    if (tracing)
+    {
+        controller.trace(&tracer, 99);
+        tracer.open(options.traceFile.empty() ? options.violationTraceFile.c_str()
+                : options.traceFile.c_str());
+    }
+    if (!options.traceFile.empty())
+    {
+        traceControl.setTimeWindow(0, std::numeric_limits<uint64_t>::max());
+    }
+    else if (!options.violationTraceFile.empty())
+    {
+        // two frames of 800 x 525 pixel clocks after the first violation
+        traceControl.arm(2 * 800 * 525 * ticksPerSecond / vgaPixelClockHz, &history,
+                options.violationTraceFile + ".history.vcd", context.timeprecisionString());
+    }
+
+    // the vga outputs once per pixel clock
+    CPinTraceWriter recorder;
+    if (!options.recordFile.empty() && !recorder.open(options.recordFile,
+            static_cast<uint32_t>(options.mode), pinNames.size(), pixelPeriodPs))
+    {
+        return false;
+    }
+    CRunTraceWriter runRecorder;
+    if (!options.runRecordFile.empty() && !runRecorder.open(options.runRecordFile,
+            static_cast<uint32_t>(options.mode), pinNames.size(), pixelPeriodPs, true))
+    {
+        return false;
+    }
+
+    monitor.setStrictMode(options.failFast ? 1 : std::numeric_limits<size_t>::max(),
+            options.warmupFrames, [&](const CVgaMonitor::TimingViolation &violation)
+            {
+                summary.violationMessages.push_back(CVgaMonitor::toString(violation));
+                traceControl.trigger(context.time());
+            });
+
+    // a restored run continues with the frame of the checkpoint
+    if (!options.restoreFile.empty()
+            && !restoreCheckpoint(options.restoreFile, context, controller, monitor))
+    {
+        return false;
+    }
+    auto checkpointFrame = monitor.getFrameCount();
+    summary.firstFrame = std::max<size_t>(1, checkpointFrame);
+
+    // the phases are marked in any case, the profiler only samples them with --profile
+    CPhaseProfiler profiler { simPhaseNames };
+    monitor.setPhaseMarker(profiler.getMarker(), toMarker(SimPhase::SAMPLING));
+    if (options.profile) profiler.start();
+
+    // the monitor samples on the rising edges, the recorders and tracers after it
+    auto monitorPeripheral = makeVgaMonitorPeripheral<VgaPins>(monitor, controller);
+    auto recording = makePeripheral([&] { profiler.mark(toMarker(SimPhase::EVAL)); },
+        [&](bool rising)
+        {
+            if (rising && recorder.isOpen())
+            {
+                profiler.mark(toMarker(SimPhase::TRACING));
+                recorder.record(static_cast<uint16_t>(getPins(controller)));
+            }
+            if (rising && runRecorder.isOpen())
+            {
+                profiler.mark(toMarker(SimPhase::TRACING));
+                runRecorder.record(static_cast<uint16_t>(getPins(controller)));
+            }
+
+            if (tracing)
+            {
+                profiler.mark(toMarker(SimPhase::TRACING));
+                if (!options.violationTraceFile.empty())
+                    history.record(context.time(), getPins(controller));
+                traceControl.dump(context.time());
+            }
+            profiler.mark(toMarker(SimPhase::OTHER));
+        });
+    CClockDomain pixelClock { controller.i_clk, vgaPixelClockHz, monitorPeripheral, recording };
+    CClockScheduler scheduler { context, controller, pixelClock };
+    if (!scheduler.isValid()) return false;
+    auto lineTicks = 800 * ticksPerSecond / vgaPixelClockHz;
+
+    // one line of 800 pixel clocks at a time, until the frame after the last one starts
+    uint64_t evaluations = 0;
+    auto start = Clock::now();
+    while ((monitor.getFrameCount() <= options.frames) && !scheduler.isFinished())
+    {
+        evaluations += scheduler.run(lineTicks);
+
+        // between edges, so that a restored run continues with the next one
+        if (!options.checkpointPrefix.empty() && (monitor.getFrameCount() != checkpointFrame))
+        {
+            checkpointFrame = monitor.getFrameCount();
+            if ((checkpointFrame % options.checkpointEvery == 0) && !saveCheckpoint(
+                    getCheckpointFileName(options.checkpointPrefix, checkpointFrame), context,
+                    controller, monitor))
+            {
+                return false;
+            }
+        }
+    }
+    auto stop = Clock::now();
+    profiler.stop();
+    if (options.profile) summary.profile = profiler.getSamples();
+
+    controller.final();
+    if (tracing) tracer.close();
+    if (!recorder.close() || !runRecorder.close()) return false;
+
+    summary.frames = summary.hashes.size();
+    summary.ticks = context.time();
+    summary.clocks = evaluations / 2;
+    summary.seconds = std::chrono::duration<double>(stop - start).count();
+    summary.violations = monitor.getViolationCount();
+    summary.statistics = monitor.getTimingStatistics();
+
+    return true;
+}
+
+bool parseRegressionOptions(const std::vector<std::string> &args, RegressionOptions &options)
+{
+    // a malformed number is an invalid argument like any other
+    try
+    {
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            const auto &arg = args[i];
+            std::string value { (i + 1 < args.size()) ? args[i + 1] : "" };
+            bool hasValue = true;
+
+            if (arg == "--mode")
+            {
+                if (value != "640x480") return false;
+                options.mode = CVgaMonitor::Mode::VGA_640x480_60Hz;
+            }
+            else if (arg == "--pattern")
+            {
+                if ((value != "psychedelic") && (value != "rgb") && (value != "chess"))
+                    return false;
+                options.pattern = value;
+            }
+            else if (arg == "--frames") options.frames = std::stoul(value);
+            else if (arg == "--warmup") options.warmupFrames = std::stoul(value);
+            else if (arg == "--tolerance") options.tolerance = std::stod(value);
+            else if (arg == "--check")
+            {
+                if (value == "off") options.policy = CVgaMonitor::CheckPolicy::OFF;
+                else if (value == "sync") options.policy = CVgaMonitor::CheckPolicy::SYNC_ONLY;
+                else if (value == "full") options.policy = CVgaMonitor::CheckPolicy::FULL;
+                else if (value == "stats")
+                    options.policy = CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS;
+                else return false;
+            }
+            else if (arg == "--trace") options.traceFile = value;
+            else if (arg == "--trace-on-violation") options.violationTraceFile = value;
+            else if (arg == "--capture") options.capturePrefix = value;
+            else if (arg == "--record") options.recordFile = value;
+            else if (arg == "--record-runs") options.runRecordFile = value;
+            else if (arg == "--checkpoint") options.checkpointPrefix = value;
+            else if (arg == "--checkpoint-every")
+                options.checkpointEvery = std::max<size_t>(1, std::stoul(value));
+            else if (arg == "--restore") options.restoreFile = value;
+            else
+            {
+                hasValue = false;
+                if (arg == "--fail-fast") options.failFast = true;
+                else if (arg == "--profile") options.profile = true;
+                else if (arg == "--json") options.json = true;
+                else return false;
+            }
+
+            if (hasValue)
+            {
+                if (i + 1 >= args.size()) return false;
+                ++i;
+            }
+        }
+    }
+    catch (const std::invalid_argument &)
+    {
+        return false;
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static std::string toHex(uint64_t value)
+{
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << value;
+    return hex.str();
+}
+
+void printRegressionText(const RegressionOptions &options, const RegressionSummary &summary)
+{
+    std::cout << "pattern: " << options.pattern << "\n"
+        << "frames: " << summary.frames << "\n"
+        << "ticks: " << summary.ticks << "\n"
+        << "seconds: " << summary.seconds << "\n"
+        << "pixel clocks: " << summary.clocks << "\n"
+        << "simulated MHz: " << summary.clocks / summary.seconds / 1.0e6 << "\n"
+        << "frames per second: " << summary.frames / summary.seconds << "\n"
+        << "timing violations: " << summary.violations << "\n";
+    for (const auto &message : summary.violationMessages)
+    {
+        std::cout << "    " << message << "\n";
+    }
+    for (size_t i = 0; i < summary.hashes.size(); ++i)
+    {
+        std::cout << "frame " << summary.firstFrame + i << " hash: " << toHex(summary.hashes[i])
+            << "\n";
+    }
+    for (size_t i = 0; i < summary.profile.size(); ++i)
+    {
+        std::cout << "profile " << simPhaseNames[i] << ": " << summary.profile[i] << "\n";
+    }
+    std::cout << "result: " << (summary.passed ? "PASS" : "FAIL") << std::endl;
+}
+
+void printRegressionJson(const RegressionOptions &options, const RegressionSummary &summary)
+{
+    std::cout << "{\n"
+        << "  \"pattern\": \"" << options.pattern << "\",\n"
+        << "  \"frames\": " << summary.frames << ",\n"
+        << "  \"ticks\": " << summary.ticks << ",\n"
+        << "  \"seconds\": " << summary.seconds << ",\n"
+        << "  \"pixel_clocks\": " << summary.clocks << ",\n"
+        << "  \"simulated_mhz\": " << summary.clocks / summary.seconds / 1.0e6 << ",\n"
+        << "  \"frames_per_second\": " << summary.frames / summary.seconds << ",\n"
+        << "  \"timing_violations\": " << summary.violations << ",\n"
+        << "  \"violations\": [";
+    for (size_t i = 0; i < summary.violationMessages.size(); ++i)
+    {
+        std::cout << (i ? ", " : "") << "\"" << summary.violationMessages[i] << "\"";
+    }
+    std::cout << "],\n  \"first_frame\": " << summary.firstFrame << ",\n  \"frame_hashes\": [";
+    for (size_t i = 0; i < summary.hashes.size(); ++i)
+    {
+        std::cout << (i ? ", " : "") << "\"" << toHex(summary.hashes[i]) << "\"";
+    }
+    std::cout << "],\n  \"profile\": {";
+    for (size_t i = 0; i < summary.profile.size(); ++i)
+    {
+        std::cout << (i ? ", " : "") << "\"" << simPhaseNames[i] << "\": " << summary.profile[i];
+    }
+    std::cout << "},\n  \"passed\": " << (summary.passed ? "true" : "false") << "\n}" << std::endl;
+}
+
+bool runRegression(const RegressionOptions &options, RegressionSummary &summary)
+{
+    bool ok = false;
+    if (options.pattern == "rgb") ok = run<VVGA_top_rgb>(options, summary);
+    else if (options.pattern == "chess") ok = run<VVGA_top_chess>(options, summary);
+    else ok = run<VVGA_top_psychedelic>(options, summary);
+
+    // a restored run hashes the frames from the one of the checkpoint on
+    auto expectedFrames = (options.frames >= summary.firstFrame)
+        ? options.frames - summary.firstFrame + 1 : 0;
+    summary.passed = ok && (summary.violations == 0) && (summary.frames == expectedFrames);
+    return ok;
+}
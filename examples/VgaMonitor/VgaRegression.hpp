@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CVgaMonitor.hpp"
+
+// Headless regression run of VGA_TLM: simulates the selected test pattern for exactly the
+// requested number of complete frames and collects the timing violations, the frame hashes
+// and the throughput. Every run uses its own VerilatedContext, so runs may execute in
+// parallel on different threads.
+
+struct RegressionOptions
+{
+    CVgaMonitor::Mode mode { CVgaMonitor::Mode::VGA_640x480_60Hz };
+    std::string pattern { "psychedelic" };
+    size_t frames { 10 };
+    size_t warmupFrames { 1 };
+    double tolerance { 0.0075 };
+    CVgaMonitor::CheckPolicy policy { CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS };
+    bool failFast { false };
+    std::string traceFile;
+    std::string violationTraceFile;
+    std::string capturePrefix;
+    std::string recordFile;
+    std::string runRecordFile;
+    std::string checkpointPrefix;
+    size_t checkpointEvery { 100 };
+    std::string restoreFile;
+    bool profile { false };
+    bool json { false };
+};
+
+struct RegressionSummary
+{
+    size_t frames { 0 };
+    size_t firstFrame { 1 };            // of the hashes, later than 1 for a restored run
+    uint64_t ticks { 0 };               // context time at the end, in the time precision
+    uint64_t clocks { 0 };              // pixel clocks simulated by this run
+    double seconds { 0.0 };
+    size_t violations { 0 };
+    std::vector<std::string> violationMessages;
+    std::vector<uint64_t> hashes;
+    CVgaMonitor::TimingStatistics statistics;
+    std::vector<size_t> profile;        // samples per SimPhase, empty without --profile
+    bool passed { false };
+};
+
+extern const char *regressionUsage;
+
+bool parseRegressionOptions(const std::vector<std::string> &args, RegressionOptions &options);
+
+// false if the simulation could not be set up
+bool runRegression(const RegressionOptions &options, RegressionSummary &summary);
+
+void printRegressionText(const RegressionOptions &options, const RegressionSummary &summary);
+void printRegressionJson(const RegressionOptions &options, const RegressionSummary &summary);
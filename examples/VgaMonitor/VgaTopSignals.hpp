@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CPinBinding.hpp"
+
+// The vga outputs of a verilated VGA_TLM, for every model prefix the design is verilated with.
+TESTBENCH_PORT(VgaHSync, o_vgaHSync);
+TESTBENCH_PORT(VgaVSync, o_vgaVSync);
+TESTBENCH_PORT(VgaR0, o_vgaR0);
+TESTBENCH_PORT(VgaR1, o_vgaR1);
+TESTBENCH_PORT(VgaR2, o_vgaR2);
+TESTBENCH_PORT(VgaG0, o_vgaG0);
+TESTBENCH_PORT(VgaG1, o_vgaG1);
+TESTBENCH_PORT(VgaG2, o_vgaG2);
+TESTBENCH_PORT(VgaB0, o_vgaB0);
+TESTBENCH_PORT(VgaB1, o_vgaB1);
+TESTBENCH_PORT(VgaB2, o_vgaB2);
+
+// The pixel clock the example designs run on by default, within the timing tolerance of the
+// monitor off the 25.175 MHz of the mode.
+constexpr uint64_t vgaPixelClockHz = 25000000;
+
+// the inputs of a CVgaMonitorPeripheral, which packed are the pins in the order of pinNames
+using VgaPins = CPinGroup<CPort<VgaHSync>, CPort<VgaVSync>,
+    CPinGroup<CPort<VgaR0>, CPort<VgaR1>, CPort<VgaR2>>,
+    CPinGroup<CPort<VgaG0>, CPort<VgaG1>, CPort<VgaG2>>,
+    CPinGroup<CPort<VgaB0>, CPort<VgaB1>, CPort<VgaB2>>>;
+
+template <typename Top>
+inline uint8_t getRed(const Top &c)
+{
+    return static_cast<uint8_t>(VgaPins::get<2>(c));
+}
+
+template <typename Top>
+inline uint8_t getGreen(const Top &c)
+{
+    return static_cast<uint8_t>(VgaPins::get<3>(c));
+}
+
+template <typename Top>
+inline uint8_t getBlue(const Top &c)
+{
+    return static_cast<uint8_t>(VgaPins::get<4>(c));
+}
+
+// all vga outputs packed into one word, in the order of pinNames
+template <typename Top>
+inline uint32_t getPins(const Top &c)
+{
+    return static_cast<uint32_t>(VgaPins::read(c));
+}
+
+const std::vector<std::string> pinNames {
+    "o_vgaHSync", "o_vgaVSync", "o_vgaR0", "o_vgaR1", "o_vgaR2", "o_vgaG0", "o_vgaG1", "o_vgaG2",
+    "o_vgaB0", "o_vgaB1", "o_vgaB2"
+};
@@ -1,28 +1,88 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <iostream>
 #include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 #include <verilated.h>
+#ifdef VGA_TRACE_FST
+#include <verilated_fst_c.h>
+#else
 #include <verilated_vcd_c.h>
+#endif
 
+#include "CClockScheduler.hpp"
+#include "CPacer.hpp"
+#include "CPhaseProfiler.hpp"
+#include "CPeripheral.hpp"
+#include "CPinTraceWriter.hpp"
+#include "CRunTraceWriter.hpp"
+#include "CSignalHistory.hpp"
+#include "CTraceEvents.hpp"
+#include "CTraceControl.hpp"
 #include "CVgaMonitor.hpp"
+#include "CVgaMonitorPeripheral.hpp"
 #include "VVGA_top.h"
+#include "VgaCheckpoint.hpp"
+#include "VgaProfilePhases.hpp"
+#include "VgaTopSignals.hpp"
 
 using namespace std::chrono_literals;
 
-inline uint8_t getRed(const VVGA_top &c)
+#ifdef VGA_TRACE_FST
+using Tracer = VerilatedFstC;
+const char *traceFileName = "vga_monitor_example.fst";
+#else
+using Tracer = VerilatedVcdC;
+const char *traceFileName = "vga_monitor_example.vcd";
+#endif
+
+bool hasPlusArg(VerilatedContext &context, const std::string &name)
 {
-    return static_cast<uint8_t>((c.o_vgaR2 << 2) | (c.o_vgaR1 << 1) | c.o_vgaR0);
+    return std::string { context.commandArgsPlusMatch(name.c_str()) } == "+" + name;
 }
 
-inline uint8_t getGreen(const VVGA_top &c)
+// value of a +name=value plusarg, or defaultValue if it was not given
+std::string getPlusArg(VerilatedContext &context, const std::string &name,
+        const std::string &defaultValue)
 {
-    return static_cast<uint8_t>((c.o_vgaG2 << 2) | (c.o_vgaG1 << 1) | c.o_vgaG0);
+    std::string match = context.commandArgsPlusMatch((name + "=").c_str());
+    if (match.empty()) return defaultValue;
+
+    return match.substr(match.find('=') + 1);
 }
 
-inline uint8_t getBlue(const VVGA_top &c)
+// a numeric plusarg, which ends the simulation if it is malformed
+template <typename Number, typename Parse>
+Number parsePlusArg(const std::string &name, const std::string &value, Parse parse)
 {
-    return static_cast<uint8_t>((c.o_vgaB2 << 2) | (c.o_vgaB1 << 1) | c.o_vgaB0);
+    try
+    {
+        return parse(value);
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+    catch (const std::out_of_range &)
+    {
+    }
+    std::cerr << "invalid +" << name << "=" << value << std::endl;
+    std::exit(EXIT_FAILURE);
+}
+
+size_t getPlusArg(VerilatedContext &context, const std::string &name, size_t defaultValue)
+{
+    auto value = getPlusArg(context, name, "");
+    if (value.empty()) return defaultValue;
+
+    return parsePlusArg<size_t>(name, value, [](const std::string &text)
+        {
+            return std::stoul(text);
+        });
 }
 
 int main(int argc, char **argv)
@@ -30,13 +90,25 @@ int main(int argc, char **argv)
     // initialize verilator variables
     VerilatedContext context;
     context.commandArgs(argc, argv);
+    context.threads(VGA_VERILATOR_THREADS);
 
     // set up the VGA controller
-    VVGA_top controller;
+    VVGA_top controller { &context };
     controller.i_clk = 0;
 
-    // set up the simulated vga monitor
-    CVgaMonitor monitor;
+    // The simulation time counts in the time precision of the design. The pixel clock runs at
+    // +pixel_clock_hz=N (default vgaPixelClockHz), the monitor accepts up to its timing
+    // tolerance off the 25.175 MHz of the mode.
+    auto ticksPerSecond = getTicksPerSecond(context);
+    auto pixelClockHz = getPlusArg(context, "pixel_clock_hz", vgaPixelClockHz);
+    auto toNanoseconds = [&](uint64_t time)
+    {
+        return std::chrono::nanoseconds { static_cast<int64_t>(time * 1e9L / ticksPerSecond) };
+    };
+
+    // set up the simulated vga monitor, the pacer takes care of the frame rate instead of vsync
+    CVgaMonitor monitor { CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS };
+    monitor.setVSync(false);
     auto monitorSetupSuccessful = monitor.setup(
         CVgaMonitor::Mode::VGA_640x480_60Hz, CVgaMonitor::ColorDepth::RGB_3BitPerColor);
     if (!monitorSetupSuccessful)
@@ -45,30 +117,232 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
     monitor.setShowTimingInfo(true);
+    monitor.setEventPumping(CVgaMonitor::EventPumping::PER_FRAME);
     monitor.setTimingTolerance(0.0075);
 
-    // set up tracing
-    context.traceEverOn(true);
-    VerilatedVcdC tracer;
-    controller.trace(&tracer, 0);
-    tracer.open("vga_monitor_example.vcd");
+    // the frame history to scrub back through keeps +history_mb=N MB (default 64, 0 is off)
+    // with a keyframe every +history_keyframes=N frames (default 30)
+    monitor.setFrameHistory(getPlusArg(context, "history_mb", 64) * 1000000,
+            getPlusArg(context, "history_keyframes", 30));
+
+    // The design runs on the pixel clock, so by default the monitor samples once per rising
+    // edge. +sampling=time samples both clock phases by elapsed time instead.
+    auto pixelClocked = (getPlusArg(context, "sampling", "pixel") != "time");
+    auto halfPixelPeriod = std::chrono::nanoseconds {
+        static_cast<int64_t>(std::llround(1e9 / (2.0 * pixelClockHz))) };
+
+    // +pacing=realtime (default) keeps the simulation from running ahead of the wall clock,
+    // +pacing=free never waits and +pacing=<factor> runs at factor times real time
+    auto pacing = getPlusArg(context, "pacing", "realtime");
+    CPacer pacer { (pacing == "free") ? CPacer::Mode::FREE_RUN
+        : (pacing == "realtime") ? CPacer::Mode::REAL_TIME : CPacer::Mode::SCALED,
+        ((pacing == "free") || (pacing == "realtime")) ? 1.0
+            : parsePlusArg<double>("pacing", pacing, [](const std::string &text)
+                {
+                    return std::stod(text);
+                }) };
+    // check the wall clock once per line of 800 pixel clocks
+    pacer.setCheckInterval(800 * 2);
+
+    // Tracing is off by default. +trace dumps the whole run, +trace_start=T, +trace_stop=T,
+    // +trace_first_frame=N and +trace_last_frame=N restrict it to a window. With
+    // +trace_on_violation the first timing violation starts tracing for +trace_post=T and
+    // writes the last +trace_history=N changes of the vga outputs to a separate file. The
+    // times are ticks of the simulation time.
+    auto traceAll = hasPlusArg(context, "trace");
+    auto traceWindow = context.commandArgsPlusMatch("trace_start=")[0]
+        || context.commandArgsPlusMatch("trace_stop=")[0]
+        || context.commandArgsPlusMatch("trace_first_frame=")[0]
+        || context.commandArgsPlusMatch("trace_last_frame=")[0];
+    auto traceOnViolation = hasPlusArg(context, "trace_on_violation");
+    auto tracing = traceAll || traceWindow || traceOnViolation;
+
+    context.traceEverOn(tracing);
+    Tracer tracer;
+    CTraceControl<Tracer> traceControl { tracer };
+    CSignalHistory history { pinNames, getPlusArg(context, "trace_history", 65536) };
+    if (tracing)
+    {
+        controller.trace(&tracer, 0);
+        tracer.open(traceFileName);
+    }
+    if (traceAll)
+    {
+        traceControl.setTimeWindow(0, std::numeric_limits<uint64_t>::max());
+    }
+    else if (traceWindow)
+    {
+        traceControl.setTimeWindow(getPlusArg(context, "trace_start", 0),
+                getPlusArg(context, "trace_stop", std::numeric_limits<uint64_t>::max()));
+        traceControl.setFrameWindow(getPlusArg(context, "trace_first_frame", 0),
+                getPlusArg(context, "trace_last_frame", std::numeric_limits<size_t>::max()));
+    }
+    if (traceOnViolation)
+    {
+        // by default trace two frames of 800 x 525 pixel clocks after the trigger
+        traceControl.arm(getPlusArg(context, "trace_post",
+                    2 * 800 * 525 * ticksPerSecond / pixelClockHz), &history,
+                "vga_monitor_example_history.vcd", context.timeprecisionString());
+    }
+
+    // +record=FILE archives the vga outputs once per pixel clock as a pin trace
+    auto pixelPeriodPs = static_cast<uint32_t>(std::llround(1e12 / pixelClockHz));
+    CPinTraceWriter recorder;
+    auto recordFile = getPlusArg(context, "record", "");
+    if (!recordFile.empty() && !recorder.open(recordFile,
+            static_cast<uint32_t>(CVgaMonitor::Mode::VGA_640x480_60Hz), pinNames.size(),
+            pixelPeriodPs))
+    {
+        return EXIT_FAILURE;
+    }
+
+    // +record_runs=FILE does the same as a run trace with a line index, ~13 KB per flat frame
+    CRunTraceWriter runRecorder;
+    auto runRecordFile = getPlusArg(context, "record_runs", "");
+    if (!runRecordFile.empty() && !runRecorder.open(runRecordFile,
+            static_cast<uint32_t>(CVgaMonitor::Mode::VGA_640x480_60Hz), pinNames.size(),
+            pixelPeriodPs, true))
+    {
+        return EXIT_FAILURE;
+    }
+
+    // +strict stops the simulation on the first timing violation after the warm-up frames,
+    // or after +max_violations=N of them. Without it violations are only reported.
+    auto strict = hasPlusArg(context, "strict");
+    if (strict || traceOnViolation)
+    {
+        monitor.setStrictMode(
+                strict ? getPlusArg(context, "max_violations", 1) : std::numeric_limits<size_t>::max(),
+                getPlusArg(context, "warmup_frames", 1),
+                [&](const CVgaMonitor::TimingViolation &violation)
+                {
+                    std::cerr << CVgaMonitor::toString(violation) << std::endl;
+                    traceControl.trigger(context.time());
+                });
+    }
+
+    // +checkpoint=PREFIX saves a checkpoint to PREFIX_<frame>.ckpt every +checkpoint_every=N
+    // frames (default 100), +restore=FILE continues a simulation from one instead of from reset
+    auto checkpointPrefix = getPlusArg(context, "checkpoint", "");
+    auto checkpointEvery = std::max<size_t>(1, getPlusArg(context, "checkpoint_every", 100));
+    auto restoreFile = getPlusArg(context, "restore", "");
+    if (!restoreFile.empty())
+    {
+        if (!restoreCheckpoint(restoreFile, context, controller, monitor)) return EXIT_FAILURE;
+        pacer.reset(toNanoseconds(context.time()));
+        std::cout << "restored frame " << monitor.getFrameCount() << " at tick " << context.time()
+            << std::endl;
+    }
+    auto checkpointFrame = monitor.getFrameCount();
+
+    // +trace_events=FILE writes the phases of the simulation and the render path as Chrome
+    // trace events at exit, in builds with VGA_TRACE_EVENTS. The simulation is recorded in
+    // batches of one line, which contain the frame work and the pacing of their ticks.
+    auto traceEventFile = getPlusArg(context, "trace_events", "");
+    CTraceEvents::setThreadName("simulation");
+    auto batchStart = CTraceEvents::Clock::now();
 
-    // Tick the clock until we are done
-    while (!Verilated::gotFinish() && !monitor.hasQuitEvent())
+    // +profile samples the phase of the simulation thread every +profile_period_us=N
+    // microseconds (default 1009) and prints the histogram at exit. The phases are always
+    // marked, the profiler only decides whether anyone looks at them.
+    CPhaseProfiler profiler { simPhaseNames };
+    monitor.setPhaseMarker(profiler.getMarker(), toMarker(SimPhase::SAMPLING));
+    auto profiling = hasPlusArg(context, "profile");
+    if (profiling)
     {
-        bool clk = context.time() % 2;
+        profiler.start(std::chrono::microseconds { getPlusArg(context, "profile_period_us",
+                1009) });
+    }
+
+    // The monitor and the testbench code around it are peripherals of the pixel clock, which
+    // the scheduler calls in this order on its edges. The recorders and tracers sample the
+    // outputs after the monitor, then the pacer waits for the wall clock.
+    auto monitorPeripheral = makeVgaMonitorPeripheral<VgaPins>(monitor, controller,
+            pixelClocked ? 0ns : halfPixelPeriod);
+    auto recording = makePeripheral([&] { profiler.mark(toMarker(SimPhase::EVAL)); },
+        [&](bool rising)
+        {
+            if (rising && recorder.isOpen())
+            {
+                profiler.mark(toMarker(SimPhase::TRACING));
+                recorder.record(static_cast<uint16_t>(getPins(controller)));
+            }
+            if (rising && runRecorder.isOpen())
+            {
+                profiler.mark(toMarker(SimPhase::TRACING));
+                runRecorder.record(static_cast<uint16_t>(getPins(controller)));
+            }
 
-        controller.i_clk = clk;
-        controller.eval();
-        monitor.eval(controller.o_vgaHSync, controller.o_vgaVSync, getRed(controller),
-                getGreen(controller), getBlue(controller), 20ns);
+            if (tracing)
+            {
+                profiler.mark(toMarker(SimPhase::TRACING));
+                if (traceOnViolation) history.record(context.time(), getPins(controller));
+                traceControl.setFrame(monitor.getFrameCount());
+                traceControl.dump(context.time());
+            }
+
+            profiler.mark(toMarker(SimPhase::PACING));
+            pacer.tick(toNanoseconds(context.time()));
+            profiler.mark(toMarker(SimPhase::OTHER));
+        });
+    CClockDomain pixelClock { controller.i_clk, pixelClockHz, monitorPeripheral, recording };
+    CClockScheduler scheduler { context, controller, pixelClock };
+    if (!scheduler.isValid()) return EXIT_FAILURE;
+    auto lineTicks = 800 * ticksPerSecond / pixelClockHz;
+
+    // Run the clock until we are done, one line of 800 pixel clocks at a time
+    while (!scheduler.isFinished())
+    {
+        // the window stays responsive while the simulation is paused with p or space
+        if (monitor.isPaused())
+        {
+            profiler.mark(toMarker(SimPhase::PAUSED));
+            pacer.reset(toNanoseconds(context.time()));
+            monitor.refreshDisplay();
+            std::this_thread::sleep_for(10ms);
+            if constexpr (CTraceEvents::enabled) batchStart = CTraceEvents::Clock::now();
+            continue;
+        }
 
-        tracer.dump(context.time());
+        scheduler.run(lineTicks);
+        if constexpr (CTraceEvents::enabled)
+        {
+            auto now = CTraceEvents::Clock::now();
+            CTraceEvents::record("simulate line", batchStart, now);
+            batchStart = now;
+        }
 
-        context.timeInc(1);
+        // between edges, so that a restored simulation continues with the next one
+        if (!checkpointPrefix.empty() && (monitor.getFrameCount() != checkpointFrame))
+        {
+            checkpointFrame = monitor.getFrameCount();
+            if (checkpointFrame % checkpointEvery == 0)
+            {
+                saveCheckpoint(getCheckpointFileName(checkpointPrefix, checkpointFrame), context,
+                        controller, monitor);
+            }
+        }
     }
 
     controller.final();
+    recorder.close();
+    runRecorder.close();
+    if (!traceEventFile.empty()) CTraceEvents::write(traceEventFile);
+    if (profiling)
+    {
+        profiler.stop();
+        profiler.print(std::cout);
+    }
+
+    // +stats prints what the peripherals counted
+    if (hasPlusArg(context, "stats")) scheduler.printStats(std::cout);
+
+    if (monitor.hasTimingFailure())
+    {
+        std::cerr << "FAILED after " << monitor.getViolationCount() << " violation(s), first "
+            << CVgaMonitor::toString(monitor.getFirstViolation()) << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
     exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,459 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <verilated.h>
+#include <verilated_fst_c.h>
+#include <verilated_vcd_c.h>
+
+#include "CClockScheduler.hpp"
+#include "CPipelinedPeripheral.hpp"
+#include "CVgaMonitor.hpp"
+#include "CVgaMonitorPeripheral.hpp"
+#include "VVGA_top_fst.h"
+#include "VVGA_top_vcd.h"
+#include "VgaBenchSweep.hpp"
+#include "VgaTopSignals.hpp"
+
+// End-to-end throughput benchmark of the VGA example design: runs VGA_TLM with a headless
+// monitor for a fixed number of frames and reports the simulated clock rate, the frame rate
+// and how the wall time splits between the model, the monitor, tracing and rendering.
+// --monitor-thread runs the monitor on its own thread, fed through a ring of pin samples, and
+// can't be combined with tracing.
+// --sweep compares untraced models verilated for the thread counts in VGA_BENCH_SWEEP_THREADS.
+// --sampling time feeds the monitor both clock phases by elapsed time instead of one sample
+// per pixel clock.
+//
+// usage: vga_bench [--frames N] [--check off|sync|full|stats] [--trace none|vcd|fst|all]
+//                  [--sampling pixel|time] [--sweep] [--monitor-thread] [--display] [--json]
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    size_t frames { 10 };
+    CVgaMonitor::CheckPolicy policy { CVgaMonitor::CheckPolicy::FULL };
+    std::string trace { "none" };
+    bool pixelClocked { true };
+    bool sweep { false };
+    bool monitorThread { false };
+    bool display { false };
+    bool json { false };
+};
+
+struct Result
+{
+    std::string trace;
+    unsigned threads { 1 };
+    bool monitorThread { false };
+    bool pixelClocked { true };
+    size_t frames { 0 };
+    uint64_t ticks { 0 };           // in the time precision of the model
+    uint64_t clocks { 0 };          // of the pixel clock
+    double seconds { 0.0 };
+    uintmax_t traceFileSize { 0 };
+
+    // measured in a separate instrumented run, as fractions of its wall time, only without
+    // the monitor thread
+    double model { 0.0 };
+    double monitor { 0.0 };
+    double tracing { 0.0 };
+    double rendering { 0.0 };
+};
+
+// half a period of the pixel clock, the elapsed time of a sample on each edge
+static std::chrono::nanoseconds getHalfPixelPeriod()
+{
+    return std::chrono::nanoseconds {
+        static_cast<int64_t>(std::llround(1e9 / (2.0 * vgaPixelClockHz))) };
+}
+
+// One simulation run on the pixel clock of the interactive example. The instrumented variant
+// reads the clock between all phases of an edge, the plain one only around the whole run so
+// that it measures the real throughput.
+template <typename Model, typename Tracer, bool instrumented>
+Result run(const Options &options, const std::string &trace, const char *traceFileName,
+        unsigned threads)
+{
+    Result result;
+    result.trace = trace;
+    result.threads = threads;
+    result.pixelClocked = options.pixelClocked;
+
+    VerilatedContext context;
+    context.threads(threads);
+    context.traceEverOn(traceFileName != nullptr);
+    Model controller { &context };
+    controller.i_clk = 0;
+
+    CVgaMonitor monitor { options.policy };
+    if (!monitor.setup(CVgaMonitor::Mode::VGA_640x480_60Hz, CVgaMonitor::ColorDepth::RGB_3BitPerColor,
+            options.display ? CVgaMonitor::Display::WINDOW : CVgaMonitor::Display::HEADLESS))
+    {
+        std::cerr << "Monitor setup failed" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    monitor.setTimingTolerance(0.0075);
+
+    Tracer tracer;
+    if (traceFileName != nullptr)
+    {
+        controller.trace(&tracer, 99);
+        tracer.open(traceFileName);
+    }
+
+    Clock::duration model { 0 };
+    Clock::duration sampling { 0 };
+    Clock::duration tracing { 0 };
+    Clock::duration rendering { 0 };
+
+    // the peripherals of an edge in order: the model split, the monitor, then the tracer
+    Clock::time_point t0;
+    Clock::time_point t1;
+    size_t frame = 0;
+    auto modelSplit = makePeripheral([&]
+        {
+            if constexpr (instrumented) t0 = Clock::now();
+        },
+        [&](bool)
+        {
+            if constexpr (instrumented)
+            {
+                t1 = Clock::now();
+                frame = monitor.getFrameCount();
+            }
+        });
+    auto monitorPeripheral = makeVgaMonitorPeripheral<VgaPins>(monitor, controller,
+            options.pixelClocked ? std::chrono::nanoseconds { 0 } : getHalfPixelPeriod());
+    auto tracerPeripheral = makePeripheral([] {}, [&](bool)
+        {
+            auto t2 = t1;
+            if constexpr (instrumented) t2 = Clock::now();
+
+            if (traceFileName != nullptr) tracer.dump(context.time());
+
+            if constexpr (instrumented)
+            {
+                auto t3 = Clock::now();
+                model += t1 - t0;
+                // the sample that starts a new frame is the one that presents the last one
+                (monitor.getFrameCount() != frame ? rendering : sampling) += t2 - t1;
+                tracing += t3 - t2;
+            }
+        });
+    CClockDomain pixelClock { controller.i_clk, vgaPixelClockHz, modelSplit, monitorPeripheral,
+        tracerPeripheral };
+    CClockScheduler scheduler { context, controller, pixelClock };
+    if (!scheduler.isValid()) std::exit(EXIT_FAILURE);
+    auto lineTicks = 800 * scheduler.getTicksPerSecond() / vgaPixelClockHz;
+
+    uint64_t evaluations = 0;
+    auto start = Clock::now();
+    while ((monitor.getFrameCount() < options.frames) && !scheduler.isFinished())
+    {
+        evaluations += scheduler.run(lineTicks);
+    }
+    auto stop = Clock::now();
+
+    controller.final();
+    if (traceFileName != nullptr)
+    {
+        tracer.close();
+        result.traceFileSize = std::filesystem::file_size(traceFileName);
+    }
+
+    result.frames = monitor.getFrameCount();
+    result.ticks = context.time();
+    result.clocks = evaluations / 2;
+    result.seconds = std::chrono::duration<double>(stop - start).count();
+    if constexpr (instrumented)
+    {
+        auto total = std::chrono::duration<double>(model + sampling + tracing + rendering).count();
+        result.model = std::chrono::duration<double>(model).count() / total;
+        result.monitor = std::chrono::duration<double>(sampling).count() / total;
+        result.tracing = std::chrono::duration<double>(tracing).count() / total;
+        result.rendering = std::chrono::duration<double>(rendering).count() / total;
+    }
+
+    return result;
+}
+
+// Untraced run with the monitor on its own thread. The simulation thread only packs the vga
+// outputs into the pipe, so its throughput is bounded by the slower of the two threads.
+template <typename Model>
+Result runPipelined(const Options &options, unsigned threads)
+{
+    Result result;
+    result.trace = "none";
+    result.threads = threads;
+    result.monitorThread = true;
+    result.pixelClocked = options.pixelClocked;
+
+    VerilatedContext context;
+    context.threads(threads);
+    Model controller { &context };
+    controller.i_clk = 0;
+
+    CSamplePipe<uint16_t> pipe;
+    std::atomic<bool> setupFailed { false };
+    auto halfPixelPeriod = getHalfPixelPeriod();
+
+    // pixel clocked sampling only needs the rising edges
+    auto sampling = makePipelinedPeripheral(pipe,
+            [&] { return static_cast<uint16_t>(getPins(controller)); }, [](uint16_t) {},
+            !options.pixelClocked);
+    CClockDomain pixelClock { controller.i_clk, vgaPixelClockHz, sampling };
+    CClockScheduler scheduler { context, controller, pixelClock };
+    if (!scheduler.isValid()) std::exit(EXIT_FAILURE);
+
+    // the monitor is created on its thread, which has to own its window if it has one
+    std::thread monitorThread { [&]()
+        {
+            CVgaMonitor monitor { options.policy };
+            bool setupDone = monitor.setup(CVgaMonitor::Mode::VGA_640x480_60Hz,
+                    CVgaMonitor::ColorDepth::RGB_3BitPerColor,
+                    options.display ? CVgaMonitor::Display::WINDOW : CVgaMonitor::Display::HEADLESS);
+            if (!setupDone) setupFailed.store(true);
+            monitor.setTimingTolerance(0.0075);
+
+            // the consumer still runs without a monitor, to stop the simulation
+            pipe.consume([&](uint16_t pins)
+                {
+                    if (!setupDone) return false;
+
+                    if (options.pixelClocked)
+                    {
+                        monitor.clockPixel(pins & 1, (pins >> 1) & 1, (pins >> 2) & 7,
+                                (pins >> 5) & 7, (pins >> 8) & 7);
+                    }
+                    else
+                    {
+                        monitor.eval(pins & 1, (pins >> 1) & 1, (pins >> 2) & 7,
+                                (pins >> 5) & 7, (pins >> 8) & 7, halfPixelPeriod);
+                    }
+                    return monitor.getFrameCount() < options.frames;
+                });
+
+            result.frames = monitor.getFrameCount();
+        } };
+
+    auto start = Clock::now();
+    auto evaluations = scheduler.run();
+    auto stop = Clock::now();
+    pipe.close();
+    monitorThread.join();
+
+    if (setupFailed.load())
+    {
+        std::cerr << "Monitor setup failed" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    controller.final();
+    result.ticks = context.time();
+    result.clocks = evaluations / 2;
+    result.seconds = std::chrono::duration<double>(stop - start).count();
+
+    return result;
+}
+
+template <typename Model, typename Tracer>
+Result measure(const Options &options, const std::string &trace, const char *traceFileName,
+        unsigned threads)
+{
+    if (options.monitorThread) return runPipelined<Model>(options, threads);
+
+    auto result = run<Model, Tracer, false>(options, trace, traceFileName, threads);
+    auto split = run<Model, Tracer, true>(options, trace, traceFileName, threads);
+
+    result.model = split.model;
+    result.monitor = split.monitor;
+    result.tracing = split.tracing;
+    result.rendering = split.rendering;
+
+    return result;
+}
+
+// measures each model of the thread count sweep
+struct SweepRun
+{
+    const Options &options;
+    std::vector<Result> &results;
+
+    template <typename Model>
+    void operator()(unsigned threads)
+    {
+        results.push_back(measure<Model, VerilatedVcdC>(options, "none", nullptr, threads));
+    }
+};
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    // a malformed number is an invalid argument like any other
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg { argv[i] };
+            std::string value { (i + 1 < argc) ? argv[i + 1] : "" };
+
+            if (arg == "--frames")
+            {
+                options.frames = std::stoul(value);
+                ++i;
+            }
+            else if (arg == "--check")
+            {
+                if (value == "off") options.policy = CVgaMonitor::CheckPolicy::OFF;
+                else if (value == "sync") options.policy = CVgaMonitor::CheckPolicy::SYNC_ONLY;
+                else if (value == "full") options.policy = CVgaMonitor::CheckPolicy::FULL;
+                else if (value == "stats")
+                    options.policy = CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS;
+                else return false;
+                ++i;
+            }
+            else if (arg == "--trace")
+            {
+                if ((value != "none") && (value != "vcd") && (value != "fst") && (value != "all"))
+                    return false;
+                options.trace = value;
+                ++i;
+            }
+            else if (arg == "--sampling")
+            {
+                if ((value != "pixel") && (value != "time")) return false;
+                options.pixelClocked = (value == "pixel");
+                ++i;
+            }
+            else if (arg == "--sweep")
+            {
+                options.sweep = true;
+            }
+            else if (arg == "--monitor-thread")
+            {
+                options.monitorThread = true;
+            }
+            else if (arg == "--display")
+            {
+                options.display = true;
+            }
+            else if (arg == "--json")
+            {
+                options.json = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
+    catch (const std::invalid_argument &)
+    {
+        return false;
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+
+    // the monitor thread is fed by an untraced model only
+    if (options.monitorThread && (options.trace != "none"))
+    {
+        std::cerr << "--monitor-thread can't be combined with tracing" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// a run too short for the clock to resolve reports no rate instead of inf or nan
+double perSecond(double count, const Result &r)
+{
+    return (r.seconds > 0.0) ? count / r.seconds : 0.0;
+}
+
+void printText(const std::vector<Result> &results)
+{
+    for (const auto &r : results)
+    {
+        std::cout << "trace " << r.trace << ", " << r.threads << " model thread(s)"
+            << (r.monitorThread ? ", monitor thread" : "")
+            << (r.pixelClocked ? ", pixel clocked" : ", time sampled") << ": "
+            << perSecond(r.clocks, r) / 1.0e6 << " MHz simulated, "
+            << perSecond(r.frames, r) << " frames/s, "
+            << r.traceFileSize << " bytes traced\n"
+            << "    model " << 100.0 * r.model << " %, monitor " << 100.0 * r.monitor
+            << " %, tracing " << 100.0 * r.tracing << " %, rendering " << 100.0 * r.rendering
+            << " %" << std::endl;
+    }
+}
+
+void printJson(const std::vector<Result> &results)
+{
+    std::cout << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto &r = results[i];
+        std::cout << "  {\n"
+            << "    \"trace\": \"" << r.trace << "\",\n"
+            << "    \"model_threads\": " << r.threads << ",\n"
+            << "    \"monitor_thread\": " << (r.monitorThread ? "true" : "false") << ",\n"
+            << "    \"sampling\": \"" << (r.pixelClocked ? "pixel" : "time") << "\",\n"
+            << "    \"frames\": " << r.frames << ",\n"
+            << "    \"ticks\": " << r.ticks << ",\n"
+            << "    \"pixel_clocks\": " << r.clocks << ",\n"
+            << "    \"seconds\": " << r.seconds << ",\n"
+            << "    \"simulated_mhz\": " << perSecond(r.clocks, r) / 1.0e6 << ",\n"
+            << "    \"frames_per_second\": " << perSecond(r.frames, r) << ",\n"
+            << "    \"trace_file_bytes\": " << r.traceFileSize << ",\n"
+            << "    \"split\": { \"model\": " << r.model << ", \"monitor\": " << r.monitor
+            << ", \"tracing\": " << r.tracing << ", \"rendering\": " << r.rendering << " }\n"
+            << "  }" << ((i + 1 < results.size()) ? "," : "") << "\n";
+    }
+    std::cout << "]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "usage: " << argv[0] << " [--frames N] [--check off|sync|full|stats]"
+            " [--trace none|vcd|fst|all] [--sampling pixel|time] [--sweep] [--monitor-thread]"
+            " [--display] [--json]"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the untraced run uses the vcd model with tracing switched off
+    const unsigned threads = VGA_VERILATOR_THREADS;
+    std::vector<Result> results;
+    if (options.sweep)
+    {
+        SweepRun sweepRun { options, results };
+        forEachSweepModel(sweepRun);
+    }
+    else
+    {
+        if ((options.trace == "none") || (options.trace == "all"))
+            results.push_back(measure<VVGA_top_vcd, VerilatedVcdC>(options, "none", nullptr,
+                    threads));
+        if ((options.trace == "vcd") || (options.trace == "all"))
+            results.push_back(measure<VVGA_top_vcd, VerilatedVcdC>(options, "vcd",
+                    "vga_bench.vcd", threads));
+        if ((options.trace == "fst") || (options.trace == "all"))
+            results.push_back(measure<VVGA_top_fst, VerilatedFstC>(options, "fst",
+                    "vga_bench.fst", threads));
+    }
+
+    if (options.json) printJson(results);
+    else printText(results);
+
+    return EXIT_SUCCESS;
+}
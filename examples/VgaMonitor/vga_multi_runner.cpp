@@ -0,0 +1,162 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CWorkStealingPool.hpp"
+#include "VgaRegression.hpp"
+
+// Parallel multi-simulation runner: reads a job file with one set of vga_runner arguments per
+// line ('#' starts a comment) and shards the simulations across the cores. Every job simulates
+// on its own VerilatedContext and model. Prints one line per job and the totals, and exits with
+// 0 if all jobs passed, 1 if one failed and 2 on an invalid job file.
+//
+// usage: vga_multi_runner [--threads N] [--json] JOBFILE
+
+using Clock = std::chrono::steady_clock;
+
+struct Job
+{
+    std::string line;
+    RegressionOptions options;
+    RegressionSummary summary;
+    bool setup { false };
+};
+
+bool readJobs(const std::string &fileName, std::vector<Job> &jobs)
+{
+    std::ifstream file { fileName };
+    if (!file)
+    {
+        std::cerr << "Can't open " << fileName << std::endl;
+        return false;
+    }
+
+    std::string line;
+    for (size_t number = 1; std::getline(file, line); ++number)
+    {
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream stream { line };
+        std::vector<std::string> args;
+        for (std::string arg; stream >> arg;)
+        {
+            args.push_back(arg);
+        }
+        if (args.empty()) continue;
+
+        Job job;
+        job.line = line.substr(line.find_first_not_of(" \t"));
+        job.line = job.line.substr(0, job.line.find_last_not_of(" \t") + 1);
+        if (!parseRegressionOptions(args, job.options))
+        {
+            std::cerr << fileName << ":" << number << ": invalid job, expected "
+                << regressionUsage << std::endl;
+            return false;
+        }
+
+        jobs.push_back(job);
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    size_t threads = 0;
+    bool json = false;
+    std::string jobFile;
+    bool valid = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg { argv[i] };
+        if ((arg == "--threads") && (i + 1 < argc))
+        {
+            try
+            {
+                threads = std::stoul(argv[++i]);
+            }
+            catch (const std::invalid_argument &)
+            {
+                valid = false;
+            }
+            catch (const std::out_of_range &)
+            {
+                valid = false;
+            }
+        }
+        else if (arg == "--json") json = true;
+        else if (jobFile.empty() && (arg[0] != '-')) jobFile = arg;
+        else valid = false;
+    }
+    if (!valid || jobFile.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " [--threads N] [--json] JOBFILE" << std::endl;
+        return 2;
+    }
+
+    std::vector<Job> jobs;
+    if (!readJobs(jobFile, jobs)) return 2;
+
+    CWorkStealingPool pool { threads };
+    std::vector<CWorkStealingPool::Job> work;
+    for (auto &job : jobs)
+    {
+        work.push_back([&job]() { job.setup = runRegression(job.options, job.summary); });
+    }
+
+    auto start = Clock::now();
+    pool.run(std::move(work));
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    size_t passed = 0;
+    uint64_t clocks = 0;
+    for (const auto &job : jobs)
+    {
+        if (job.summary.passed) ++passed;
+        clocks += job.summary.clocks;
+    }
+    double simulatedMhz = clocks / seconds / 1.0e6;
+
+    if (json)
+    {
+        std::cout << "{\n  \"threads\": " << pool.getThreadCount() << ",\n  \"jobs\": [\n";
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            const auto &summary = jobs[i].summary;
+            std::cout << "    { \"job\": \"" << jobs[i].line << "\", \"setup\": "
+                << (jobs[i].setup ? "true" : "false") << ", \"frames\": " << summary.frames
+                << ", \"seconds\": " << summary.seconds << ", \"timing_violations\": "
+                << summary.violations << ", \"passed\": " << (summary.passed ? "true" : "false")
+                << " }" << ((i + 1 < jobs.size()) ? "," : "") << "\n";
+        }
+        std::cout << "  ],\n"
+            << "  \"passed\": " << passed << ",\n"
+            << "  \"failed\": " << jobs.size() - passed << ",\n"
+            << "  \"seconds\": " << seconds << ",\n"
+            << "  \"simulated_mhz\": " << simulatedMhz << "\n}" << std::endl;
+    }
+    else
+    {
+        for (const auto &job : jobs)
+        {
+            const auto &summary = job.summary;
+            std::cout << std::left << std::setw(6)
+                << (!job.setup ? "ERROR" : (summary.passed ? "PASS" : "FAIL")) << std::right
+                << std::setw(6) << summary.frames << " frames" << std::setw(6)
+                << summary.violations << " violations" << std::fixed << std::setprecision(2)
+                << std::setw(9) << summary.seconds << " s   " << job.line << "\n";
+        }
+        std::cout << "threads: " << pool.getThreadCount() << "\n"
+            << "passed: " << passed << "/" << jobs.size() << "\n"
+            << "seconds: " << seconds << "\n"
+            << "simulated MHz: " << simulatedMhz << std::endl;
+    }
+
+    return (passed == jobs.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,443 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CPinTraceReader.hpp"
+#include "CRunTraceReader.hpp"
+#include "CVgaMonitor.hpp"
+#include "CWorkStealingPool.hpp"
+#include "VgaFrameCapture.hpp"
+
+// Replays a pin trace recorded with +record or --record, or a run trace recorded with
+// +record_runs or --record-runs, into the monitor without simulating the design: re-checks the
+// timing and re-renders the frames at the speed of the monitor. Runs are checked and drawn
+// whole, without expanding them to samples. With --threads the trace is split at frame starts
+// and the chunks are checked in parallel, each by its own monitor. Exits with 0 if no violation
+// occurred after the warm-up frames, 1 if one did and 2 on invalid arguments or an unreadable
+// trace.
+//
+// usage: vga_replay [--check off|sync|full|stats] [--tolerance T] [--warmup N] [--threads N]
+//                   [--batch N] [--capture PREFIX] [--display] [--json] FILE
+
+using Clock = std::chrono::steady_clock;
+
+// The recorded pins, either one sample per pixel clock or runs of equal samples. Positions in
+// the trace count samples resp. runs.
+struct Trace
+{
+    const uint16_t *samples { nullptr };
+    const uint32_t *runs { nullptr };
+    size_t size { 0 };
+    const uint64_t *lineIndex { nullptr };
+    size_t lineCount { 0 };
+    const RunIndexEntry *frameIndex { nullptr };
+    size_t frameCount { 0 };
+
+    uint16_t pins(size_t i) const { return runs ? (runs[i] & 0xffff) : samples[i]; }
+
+    void clock(CVgaMonitor &monitor, size_t begin, size_t end) const
+    {
+        if (runs) monitor.clockRuns(runs + begin, end - begin);
+        else monitor.clockPixels(samples + begin, end - begin);
+    }
+
+    // the first sample at position i
+    void clockFirst(CVgaMonitor &monitor, size_t i) const
+    {
+        uint32_t first = pins(i) | (1u << 16);
+        if (runs) monitor.clockRuns(&first, 1);
+        else monitor.clockPixels(samples + i, 1);
+    }
+
+    // the samples at position i after the first
+    void clockRest(CVgaMonitor &monitor, size_t i) const
+    {
+        uint32_t rest = runs ? runs[i] - (1u << 16) : 0;
+        if (rest >> 16) monitor.clockRuns(&rest, 1);
+    }
+};
+
+struct Options
+{
+    std::string traceFile;
+    CVgaMonitor::CheckPolicy policy { CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS };
+    double tolerance { 0.0075 };
+    size_t warmupFrames { 1 };
+    size_t threads { 1 };
+    size_t batch { 65536 };
+    std::string capturePrefix;
+    bool display { false };
+    bool json { false };
+};
+
+// A frame aligned part of the trace. All but the first chunk start at a vsync falling edge
+// and are preceded by a lead-in from the last hsync falling edge, which brings the monitor in
+// sync; the lead-in was checked by the previous chunk. A chunk also takes the first sample of
+// the next one, which completes its last frame.
+struct Chunk
+{
+    size_t leadIn { 0 };
+    size_t begin { 0 };
+    size_t end { 0 };
+    size_t nextFirstFrame { std::numeric_limits<size_t>::max() };
+    size_t frameOffset { 0 };   // global index of the chunk's local frame 0
+
+    bool ok { false };
+    std::vector<std::pair<size_t, uint64_t>> hashes;
+    std::vector<CVgaMonitor::TimingViolation> violations;
+    CVgaMonitor::TimingStatistics statistics;
+};
+
+struct Summary
+{
+    size_t samples { 0 };
+    size_t runs { 0 };
+    size_t chunks { 0 };
+    size_t frames { 0 };
+    double seconds { 0.0 };
+    std::vector<CVgaMonitor::TimingViolation> violations;
+    std::vector<std::pair<size_t, uint64_t>> hashes;
+    CVgaMonitor::TimingStatistics statistics;
+    bool passed { false };
+};
+
+// a recorded index saves scanning the trace for the sync edges
+std::vector<Chunk> splitTrace(const Trace &trace, size_t chunks)
+{
+    std::vector<size_t> frameStarts;
+    for (size_t i = 0; i < trace.frameCount; ++i)
+    {
+        frameStarts.push_back(trace.frameIndex[i].run);
+    }
+    for (size_t i = 1; (trace.frameCount == 0) && (i < trace.size); ++i)
+    {
+        if ((trace.pins(i - 1) & 2) && !(trace.pins(i) & 2)) frameStarts.push_back(i);
+    }
+    chunks = std::max<size_t>(1, std::min(chunks, frameStarts.size()));
+
+    std::vector<Chunk> result(chunks);
+    for (size_t n = 1; n < chunks; ++n)
+    {
+        // the frame starting at frameStarts[j] is frame j + 1, frame 0 precedes the first vsync
+        size_t j = n * frameStarts.size() / chunks;
+        auto &chunk = result[n];
+        chunk.begin = frameStarts[j];
+        chunk.frameOffset = j;
+        result[n - 1].nextFirstFrame = j + 1;
+
+        chunk.leadIn = chunk.begin - 1;
+        if (trace.lineCount > 0)
+        {
+            auto line = std::upper_bound(trace.lineIndex, trace.lineIndex + trace.lineCount,
+                    chunk.leadIn);
+            chunk.leadIn = (line != trace.lineIndex) ? std::max<size_t>(1, *(line - 1)) : 1;
+        }
+        while ((chunk.leadIn > 1)
+                && !((trace.pins(chunk.leadIn - 1) & 1) && !(trace.pins(chunk.leadIn) & 1)))
+        {
+            --chunk.leadIn;
+        }
+        if (chunk.leadIn > 0) --chunk.leadIn;
+    }
+    for (size_t n = 0; n < chunks; ++n)
+    {
+        result[n].end = (n + 1 < chunks) ? result[n + 1].begin : trace.size;
+    }
+
+    return result;
+}
+
+void replayChunk(const Options &options, const Trace &trace, Chunk &chunk, bool first)
+{
+    CVgaMonitor monitor { options.policy };
+    if (!monitor.setup(CVgaMonitor::Mode::VGA_640x480_60Hz,
+            CVgaMonitor::ColorDepth::RGB_3BitPerColor,
+            options.display ? CVgaMonitor::Display::WINDOW : CVgaMonitor::Display::HEADLESS))
+    {
+        std::cerr << "Monitor setup failed" << std::endl;
+        return;
+    }
+    monitor.setTimingTolerance(options.tolerance);
+    monitor.setShowTimingInfo(options.display);
+
+    // local frame 0 is the lead-in of all but the first chunk
+    auto isOwnFrame = [&](size_t local)
+        {
+            return (first || (local > 0)) && ((local + chunk.frameOffset) < chunk.nextFirstFrame);
+        };
+
+    std::vector<uint32_t> frame;
+    monitor.setFrameCallback([&](size_t local)
+        {
+            size_t index = local + chunk.frameOffset;
+            if ((index == 0) || (!first && (local == 0))) return;
+
+            chunk.hashes.emplace_back(index, monitor.hashFrame());
+            if (!options.capturePrefix.empty())
+            {
+                monitor.copyFrame(frame);
+                std::ostringstream fileName;
+                fileName << options.capturePrefix << "_" << std::setw(5) << std::setfill('0')
+                    << index << ".ppm";
+                writePpm(fileName.str(), frame, monitor.getWidth(), monitor.getHeight());
+            }
+        });
+    monitor.setStrictMode(std::numeric_limits<size_t>::max(), 0,
+            [&](const CVgaMonitor::TimingViolation &violation)
+            {
+                if (!isOwnFrame(violation.frame)) return;
+
+                auto global = violation;
+                global.frame += chunk.frameOffset;
+                if (global.frame >= options.warmupFrames) chunk.violations.push_back(global);
+            });
+
+    // the lead-in and the frame start were counted by the previous chunk
+    size_t i = chunk.leadIn;
+    if (!first)
+    {
+        trace.clock(monitor, i, chunk.begin);
+        trace.clockFirst(monitor, chunk.begin);
+        monitor.resetTimingStatistics();
+        trace.clockRest(monitor, chunk.begin);
+        i = chunk.begin + 1;
+    }
+    while ((i < chunk.end) && !monitor.hasQuitEvent())
+    {
+        size_t count = std::min(options.batch, chunk.end - i);
+        trace.clock(monitor, i, i + count);
+        i += count;
+    }
+    if (chunk.end < trace.size) trace.clockFirst(monitor, chunk.end);
+
+    chunk.statistics = monitor.getTimingStatistics();
+    chunk.ok = true;
+}
+
+bool replay(const Options &options, const Trace &trace, Summary &summary)
+{
+    // a window belongs to a single monitor, so a displayed replay is not split
+    size_t chunks = options.display ? 1 : 4 * options.threads;
+    auto parts = splitTrace(trace, (options.threads > 1) ? chunks : 1);
+
+    std::vector<CWorkStealingPool::Job> jobs;
+    for (size_t n = 0; n < parts.size(); ++n)
+    {
+        jobs.push_back([&, n]() { replayChunk(options, trace, parts[n], n == 0); });
+    }
+
+    auto start = Clock::now();
+    CWorkStealingPool { options.display ? 1 : options.threads }.run(std::move(jobs));
+    summary.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    summary.chunks = parts.size();
+    for (const auto &chunk : parts)
+    {
+        if (!chunk.ok) return false;
+
+        summary.hashes.insert(summary.hashes.end(), chunk.hashes.begin(), chunk.hashes.end());
+        summary.violations.insert(summary.violations.end(), chunk.violations.begin(),
+                chunk.violations.end());
+
+        summary.statistics.frames += chunk.statistics.frames;
+        summary.statistics.framesWithViolations += chunk.statistics.framesWithViolations;
+        for (size_t bit = 0; bit < summary.statistics.hViolations.size(); ++bit)
+        {
+            summary.statistics.hViolations[bit] += chunk.statistics.hViolations[bit];
+            summary.statistics.vViolations[bit] += chunk.statistics.vViolations[bit];
+        }
+    }
+    summary.frames = summary.hashes.size();
+    summary.passed = summary.violations.empty();
+
+    return true;
+}
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    // a malformed number is an invalid argument like any other
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg { argv[i] };
+            std::string value { (i + 1 < argc) ? argv[i + 1] : "" };
+            bool hasValue = true;
+
+            if (arg == "--check")
+            {
+                if (value == "off") options.policy = CVgaMonitor::CheckPolicy::OFF;
+                else if (value == "sync") options.policy = CVgaMonitor::CheckPolicy::SYNC_ONLY;
+                else if (value == "full") options.policy = CVgaMonitor::CheckPolicy::FULL;
+                else if (value == "stats")
+                    options.policy = CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS;
+                else return false;
+            }
+            else if (arg == "--tolerance") options.tolerance = std::stod(value);
+            else if (arg == "--warmup") options.warmupFrames = std::stoul(value);
+            else if (arg == "--threads") options.threads = std::max<size_t>(1, std::stoul(value));
+            else if (arg == "--batch") options.batch = std::max<size_t>(1, std::stoul(value));
+            else if (arg == "--capture") options.capturePrefix = value;
+            else
+            {
+                hasValue = false;
+                if (arg == "--display") options.display = true;
+                else if (arg == "--json") options.json = true;
+                else if (options.traceFile.empty() && (arg[0] != '-')) options.traceFile = arg;
+                else return false;
+            }
+
+            if (hasValue)
+            {
+                if (i + 1 >= argc) return false;
+                ++i;
+            }
+        }
+    }
+    catch (const std::invalid_argument &)
+    {
+        return false;
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+
+    return !options.traceFile.empty();
+}
+
+std::string toHex(uint64_t value)
+{
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << value;
+    return hex.str();
+}
+
+void printText(const Options &options, uint64_t samplePeriodPs, const Summary &summary)
+{
+    std::cout << "trace: " << options.traceFile << "\n"
+        << "samples: " << summary.samples << "\n";
+    if (summary.runs > 0) std::cout << "runs: " << summary.runs << "\n";
+    std::cout << "sample period: " << samplePeriodPs << " ps\n"
+        << "chunks: " << summary.chunks << "\n"
+        << "frames: " << summary.frames << "\n"
+        << "seconds: " << summary.seconds << "\n"
+        << "Msamples/s: " << summary.samples / summary.seconds / 1.0e6 << "\n"
+        << "frames per second: " << summary.frames / summary.seconds << "\n"
+        << "timing violations: " << summary.violations.size() << "\n";
+    if (options.policy == CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS)
+    {
+        std::cout << "frames with violations: " << summary.statistics.framesWithViolations
+            << " / " << summary.statistics.frames << "\n"
+            << "violating samples h/v:";
+        for (size_t bit = 0; bit < summary.statistics.hViolations.size(); ++bit)
+        {
+            std::cout << " " << summary.statistics.hViolations[bit] << "/"
+                << summary.statistics.vViolations[bit];
+        }
+        std::cout << "\n";
+    }
+    for (const auto &violation : summary.violations)
+    {
+        std::cout << "    " << CVgaMonitor::toString(violation) << "\n";
+    }
+    for (const auto &hash : summary.hashes)
+    {
+        std::cout << "frame " << hash.first << " hash: " << toHex(hash.second) << "\n";
+    }
+    std::cout << "result: " << (summary.passed ? "PASS" : "FAIL") << std::endl;
+}
+
+void printJson(const Options &options, uint64_t samplePeriodPs, const Summary &summary)
+{
+    std::cout << "{\n"
+        << "  \"trace\": \"" << options.traceFile << "\",\n"
+        << "  \"samples\": " << summary.samples << ",\n"
+        << "  \"runs\": " << summary.runs << ",\n"
+        << "  \"sample_period_ps\": " << samplePeriodPs << ",\n"
+        << "  \"chunks\": " << summary.chunks << ",\n"
+        << "  \"frames\": " << summary.frames << ",\n"
+        << "  \"seconds\": " << summary.seconds << ",\n"
+        << "  \"msamples_per_second\": " << summary.samples / summary.seconds / 1.0e6 << ",\n"
+        << "  \"frames_per_second\": " << summary.frames / summary.seconds << ",\n"
+        << "  \"timing_violations\": " << summary.violations.size() << ",\n";
+    if (options.policy == CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS)
+    {
+        std::cout << "  \"frames_with_violations\": " << summary.statistics.framesWithViolations
+            << ",\n";
+    }
+    std::cout << "  \"violations\": [";
+    for (size_t i = 0; i < summary.violations.size(); ++i)
+    {
+        std::cout << (i ? ", " : "") << "\"" << CVgaMonitor::toString(summary.violations[i])
+            << "\"";
+    }
+    std::cout << "],\n  \"frame_hashes\": [";
+    for (size_t i = 0; i < summary.hashes.size(); ++i)
+    {
+        std::cout << (i ? ", " : "") << "\"" << toHex(summary.hashes[i].second) << "\"";
+    }
+    std::cout << "],\n  \"passed\": " << (summary.passed ? "true" : "false") << "\n}" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "usage: " << argv[0] << " [--check off|sync|full|stats] [--tolerance T]"
+            " [--warmup N] [--threads N] [--batch N] [--capture PREFIX] [--display] [--json]"
+            " FILE" << std::endl;
+        return 2;
+    }
+
+    CPinTraceReader pinTrace;
+    CRunTraceReader runTrace;
+    Trace trace;
+    Summary summary;
+    uint32_t mode = 0;
+    uint64_t samplePeriodPs = 0;
+    if (CRunTraceReader::isRunTrace(options.traceFile))
+    {
+        if (!runTrace.open(options.traceFile)) return 2;
+        trace.runs = runTrace.data();
+        trace.size = runTrace.size();
+        trace.lineIndex = runTrace.getLineIndex();
+        trace.lineCount = runTrace.getLineCount();
+        trace.frameIndex = runTrace.getFrameIndex();
+        trace.frameCount = runTrace.getFrameCount();
+        mode = runTrace.getHeader().mode;
+        samplePeriodPs = runTrace.getHeader().samplePeriodPs;
+        summary.samples = runTrace.getHeader().sampleCount;
+        summary.runs = runTrace.size();
+    }
+    else
+    {
+        if (!pinTrace.open(options.traceFile)) return 2;
+        trace.samples = pinTrace.data();
+        trace.size = pinTrace.size();
+        mode = pinTrace.getHeader().mode;
+        samplePeriodPs = pinTrace.getHeader().samplePeriodPs;
+        summary.samples = pinTrace.size();
+    }
+    if (mode != static_cast<uint32_t>(CVgaMonitor::Mode::VGA_640x480_60Hz))
+    {
+        std::cerr << options.traceFile << " was recorded in an unsupported mode" << std::endl;
+        return 2;
+    }
+
+    if (!replay(options, trace, summary)) return 2;
+
+    if (options.json) printJson(options, samplePeriodPs, summary);
+    else printText(options, samplePeriodPs, summary);
+
+    return summary.passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
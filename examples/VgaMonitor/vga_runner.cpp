@@ -0,0 +1,31 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "VgaRegression.hpp"
+
+// Headless batch runner for regression runs: simulates VGA_TLM with the selected test pattern
+// for exactly the requested number of complete frames and prints a summary of the timing
+// violations, the frame hashes and the throughput. Exits with 0 if no violation occurred after
+// the warm-up frames, 1 if one did and 2 on invalid arguments or a failed setup.
+//
+// usage: vga_runner followed by the options in regressionUsage, see VgaRegression.cpp
+
+int main(int argc, char **argv)
+{
+    RegressionOptions options;
+    if (!parseRegressionOptions({ argv + 1, argv + argc }, options))
+    {
+        std::cerr << "usage: " << argv[0] << " " << regressionUsage << std::endl;
+        return 2;
+    }
+
+    RegressionSummary summary;
+    if (!runRegression(options, summary)) return 2;
+
+    if (options.json) printRegressionJson(options, summary);
+    else printRegressionText(options, summary);
+
+    return summary.passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
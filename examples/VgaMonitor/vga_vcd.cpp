@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CVcdReader.hpp"
+#include "CVgaMonitor.hpp"
+#include "VgaFrameCapture.hpp"
+#include "VgaTopSignals.hpp"
+
+// Drives the monitor from an existing VCD file, e.g. a dump of Icarus or another simulator,
+// without simulating the design. The file is streamed, so dumps of any size work, and every
+// value change of the vga signals is one edge-driven monitor call. The signals are found by
+// the port names of VGA_TLM; --scope selects the instance and --signal PIN=NAME maps a pin to a
+// differently named signal, a vector to the pins from PIN on. --timescale overrides the time
+// unit of the dump, for dumps that state a wrong one; the example's traces carry the unit of
+// the design's `timescale and need none. Exits with 0 if no violation occurred after the
+// warm-up frames, 1 if one did and 2 on invalid arguments or an unreadable file.
+//
+// usage: vga_vcd [--check off|sync|full|stats] [--tolerance T] [--warmup N] [--timescale T]
+//                [--scope SCOPE] [--signal PIN=NAME]... [--capture PREFIX] [--display] [--json]
+//                FILE
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::string vcdFile;
+    CVgaMonitor::CheckPolicy policy { CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS };
+    double tolerance { 0.0075 };
+    size_t warmupFrames { 1 };
+    std::string timescale;
+    std::string scope;
+    std::vector<std::string> signals { pinNames };
+    std::string capturePrefix;
+    bool display { false };
+    bool json { false };
+};
+
+struct Summary
+{
+    size_t changes { 0 };
+    uint64_t endTimeNs { 0 };
+    size_t frames { 0 };
+    double seconds { 0.0 };
+    std::vector<std::string> violations;
+    std::vector<uint64_t> hashes;
+    bool passed { false };
+};
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    // a malformed number is an invalid argument like any other
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg { argv[i] };
+            std::string value { (i + 1 < argc) ? argv[i + 1] : "" };
+            bool hasValue = true;
+
+            if (arg == "--check")
+            {
+                if (value == "off") options.policy = CVgaMonitor::CheckPolicy::OFF;
+                else if (value == "sync") options.policy = CVgaMonitor::CheckPolicy::SYNC_ONLY;
+                else if (value == "full") options.policy = CVgaMonitor::CheckPolicy::FULL;
+                else if (value == "stats")
+                    options.policy = CVgaMonitor::CheckPolicy::FULL_WITH_STATISTICS;
+                else return false;
+            }
+            else if (arg == "--tolerance") options.tolerance = std::stod(value);
+            else if (arg == "--warmup") options.warmupFrames = std::stoul(value);
+            else if (arg == "--timescale") options.timescale = value;
+            else if (arg == "--scope") options.scope = value;
+            else if (arg == "--signal")
+            {
+                auto separator = value.find('=');
+                size_t pin = 0;
+                auto name = value.substr(0, separator);
+                while ((pin < pinNames.size()) && (pinNames[pin] != name)) ++pin;
+                if ((separator == std::string::npos) || (pin == pinNames.size())) return false;
+                options.signals[pin] = value.substr(separator + 1);
+            }
+            else if (arg == "--capture") options.capturePrefix = value;
+            else
+            {
+                hasValue = false;
+                if (arg == "--display") options.display = true;
+                else if (arg == "--json") options.json = true;
+                else if (options.vcdFile.empty() && (arg[0] != '-')) options.vcdFile = arg;
+                else return false;
+            }
+
+            if (hasValue)
+            {
+                if (i + 1 >= argc) return false;
+                ++i;
+            }
+        }
+    }
+    catch (const std::invalid_argument &)
+    {
+        return false;
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+
+    return !options.vcdFile.empty();
+}
+
+bool parseTimescalePs(const std::string &timescale, uint64_t &ps)
+{
+    size_t unit = 0;
+    uint64_t number = 0;
+    try
+    {
+        number = std::stoull(timescale, &unit);
+    }
+    catch (const std::invalid_argument &)
+    {
+        return false;
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+    auto suffix = timescale.substr(unit);
+
+    if (suffix == "us") ps = number * 1000000;
+    else if (suffix == "ns") ps = number * 1000;
+    else if (suffix == "ps") ps = number;
+    else return false;
+
+    return true;
+}
+
+bool run(const Options &options, Summary &summary)
+{
+    CVcdReader reader;
+    if (!reader.open(options.vcdFile) || !reader.readHeader()) return false;
+
+    // a vector covers the pins following its own, unless they were mapped explicitly
+    size_t coveredEnd = 0;
+    for (size_t pin = 0; pin < options.signals.size(); ++pin)
+    {
+        if ((pin < coveredEnd) && (options.signals[pin] == pinNames[pin])) continue;
+
+        auto name = options.scope.empty() ? options.signals[pin]
+            : options.scope + "." + options.signals[pin];
+        size_t width = reader.mapSignal(name, pin);
+        if (width == 0) return false;
+        coveredEnd = std::max(coveredEnd, pin + width);
+    }
+
+    uint64_t timescalePs = reader.getTimescalePs();
+    if (!options.timescale.empty())
+    {
+        if (!parseTimescalePs(options.timescale, timescalePs))
+        {
+            std::cerr << "invalid timescale " << options.timescale << std::endl;
+            return false;
+        }
+    }
+
+    CVgaMonitor monitor { options.policy };
+    if (!monitor.setup(CVgaMonitor::Mode::VGA_640x480_60Hz,
+            CVgaMonitor::ColorDepth::RGB_3BitPerColor,
+            options.display ? CVgaMonitor::Display::WINDOW : CVgaMonitor::Display::HEADLESS))
+    {
+        std::cerr << "Monitor setup failed" << std::endl;
+        return false;
+    }
+    monitor.setTimingTolerance(options.tolerance);
+    monitor.setShowTimingInfo(options.display);
+
+    // hash and capture every complete frame, frame 0 is the one before the first vsync
+    std::vector<uint32_t> frame;
+    monitor.setFrameCallback([&](size_t index)
+        {
+            if (index == 0) return;
+
+            summary.hashes.push_back(monitor.hashFrame());
+            if (!options.capturePrefix.empty())
+            {
+                monitor.copyFrame(frame);
+                std::ostringstream fileName;
+                fileName << options.capturePrefix << "_" << std::setw(5) << std::setfill('0')
+                    << index << ".ppm";
+                writePpm(fileName.str(), frame, monitor.getWidth(), monitor.getHeight());
+            }
+        });
+    monitor.setStrictMode(std::numeric_limits<size_t>::max(), options.warmupFrames,
+            [&](const CVgaMonitor::TimingViolation &violation)
+            {
+                summary.violations.push_back(CVgaMonitor::toString(violation));
+            });
+
+    // each change is passed on once the next one tells how long it held
+    uint32_t pins = 0;
+    uint64_t changeNs = 0;
+    auto hold = [&](uint64_t ns)
+        {
+            monitor.evalChange(pins & 1, (pins >> 1) & 1, (pins >> 2) & 7, (pins >> 5) & 7,
+                    (pins >> 8) & 7, std::chrono::nanoseconds { ns - changeNs });
+        };
+
+    auto start = Clock::now();
+    bool ok = reader.read([&](uint64_t time, uint32_t values)
+        {
+            uint64_t ns = time * timescalePs / 1000;
+            if (summary.changes > 0) hold(ns);
+
+            pins = values;
+            changeNs = ns;
+            ++summary.changes;
+        });
+    summary.endTimeNs = reader.getEndTime() * timescalePs / 1000;
+    if (ok && (summary.changes > 0) && (summary.endTimeNs > changeNs)) hold(summary.endTimeNs);
+    summary.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    summary.frames = summary.hashes.size();
+    summary.passed = ok && summary.violations.empty();
+
+    return ok;
+}
+
+std::string toHex(uint64_t value)
+{
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << value;
+    return hex.str();
+}
+
+void printText(const Options &options, const Summary &summary)
+{
+    auto bytes = std::filesystem::file_size(options.vcdFile);
+    std::cout << "vcd: " << options.vcdFile << "\n"
+        << "value changes: " << summary.changes << "\n"
+        << "simulated ms: " << summary.endTimeNs / 1.0e6 << "\n"
+        << "frames: " << summary.frames << "\n"
+        << "seconds: " << summary.seconds << "\n"
+        << "MB/s: " << bytes / summary.seconds / 1.0e6 << "\n"
+        << "timing violations: " << summary.violations.size() << "\n";
+    for (const auto &message : summary.violations)
+    {
+        std::cout << "    " << message << "\n";
+    }
+    for (size_t i = 0; i < summary.hashes.size(); ++i)
+    {
+        std::cout << "frame " << i + 1 << " hash: " << toHex(summary.hashes[i]) << "\n";
+    }
+    std::cout << "result: " << (summary.passed ? "PASS" : "FAIL") << std::endl;
+}
+
+void printJson(const Options &options, const Summary &summary)
+{
+    auto bytes = std::filesystem::file_size(options.vcdFile);
+    std::cout << "{\n"
+        << "  \"vcd\": \"" << options.vcdFile << "\",\n"
+        << "  \"value_changes\": " << summary.changes << ",\n"
+        << "  \"simulated_ns\": " << summary.endTimeNs << ",\n"
+        << "  \"frames\": " << summary.frames << ",\n"
+        << "  \"seconds\": " << summary.seconds << ",\n"
+        << "  \"mb_per_second\": " << bytes / summary.seconds / 1.0e6 << ",\n"
+        << "  \"timing_violations\": " << summary.violations.size() << ",\n"
+        << "  \"violations\": [";
+    for (size_t i = 0; i < summary.violations.size(); ++i)
+    {
+        std::cout << (i ? ", " : "") << "\"" << summary.violations[i] << "\"";
+    }
+    std::cout << "],\n  \"frame_hashes\": [";
+    for (size_t i = 0; i < summary.hashes.size(); ++i)
+    {
+        std::cout << (i ? ", " : "") << "\"" << toHex(summary.hashes[i]) << "\"";
+    }
+    std::cout << "],\n  \"passed\": " << (summary.passed ? "true" : "false") << "\n}" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "usage: " << argv[0] << " [--check off|sync|full|stats] [--tolerance T]"
+            " [--warmup N] [--timescale T] [--scope SCOPE] [--signal PIN=NAME]..."
+            " [--capture PREFIX] [--display] [--json] FILE" << std::endl;
+        return 2;
+    }
+
+    Summary summary;
+    if (!run(options, summary)) return 2;
+
+    if (options.json) printJson(options, summary);
+    else printText(options, summary);
+
+    return summary.passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
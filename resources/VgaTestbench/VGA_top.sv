@@ -2,6 +2,10 @@
 `timescale 1ns/1ns
 
 module VGA_TLM
+#(
+    // 0: psychedelic, 1: red, green and blue bars, 2: chessboard
+    parameter PATTERN = 0
+)
 (
     input i_clk,
     output o_vgaHSync,
@@ -49,17 +53,50 @@ module VGA_TLM
     wire [2:0] w_green;
     wire [2:0] w_blue;
 
-    VGA_PSYCHEDELIC_PATTERN psychPattern
-    (
-        .i_clk(i_clk),
-        .i_reset(w_reset),
-        .i_px(w_px),
-        .i_py(w_py),
-        .i_activeArea(w_activeArea),
-        .o_red(w_red),
-        .o_green(w_green),
-        .o_blue(w_blue)
-    );
+    generate
+        if (PATTERN == 1)
+        begin : g_rgbPattern
+            VGA_RGB_PATTERN rgbPattern
+            (
+                .i_clk(i_clk),
+                .i_reset(w_reset),
+                .i_px(w_px),
+                .i_py(w_py),
+                .i_activeArea(w_activeArea),
+                .o_red(w_red),
+                .o_green(w_green),
+                .o_blue(w_blue)
+            );
+        end
+        else if (PATTERN == 2)
+        begin : g_chessPattern
+            VGA_CHESS_PATTERN chessPattern
+            (
+                .i_clk(i_clk),
+                .i_reset(w_reset),
+                .i_px(w_px),
+                .i_py(w_py),
+                .i_activeArea(w_activeArea),
+                .o_red(w_red),
+                .o_green(w_green),
+                .o_blue(w_blue)
+            );
+        end
+        else
+        begin : g_psychPattern
+            VGA_PSYCHEDELIC_PATTERN psychPattern
+            (
+                .i_clk(i_clk),
+                .i_reset(w_reset),
+                .i_px(w_px),
+                .i_py(w_py),
+                .i_activeArea(w_activeArea),
+                .o_red(w_red),
+                .o_green(w_green),
+                .o_blue(w_blue)
+            );
+        end
+    endgenerate
 
     assign o_vgaR0 = w_red[0];
     assign o_vgaR1 = w_red[1];
@@ -64,7 +64,9 @@ module VGA_RGB_PATTERN
     input i_clk,
     input i_reset,
     input [9:0] i_px,
+    /* verilator lint_off UNUSED */
     input [9:0] i_py,
+    /* verilator lint_on UNUSED */
     input i_activeArea,
     output [2:0] o_red,
     output [2:0] o_green,
@@ -116,8 +118,10 @@ module VGA_CHESS_PATTERN
 (
     input i_clk,
     input i_reset,
+    /* verilator lint_off UNUSED */
     input [9:0] i_px,
     input [9:0] i_py,
+    /* verilator lint_on UNUSED */
     input i_activeArea,
     output [2:0] o_red,
     output [2:0] o_green,
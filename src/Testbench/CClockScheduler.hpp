@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <ostream>
+#include <queue>
+#include <ratio>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <verilated.h>
+
+#include "CPeripheral.hpp"
+
+// ticks of the context time per second, from the time precision of the verilated design
+inline uint64_t getTicksPerSecond(const VerilatedContext &context)
+{
+    uint64_t ticksPerSecond = 1;
+    for (int exponent = context.timeprecision(); exponent < 0; ++exponent) ticksPerSecond *= 10;
+    return ticksPerSecond;
+}
+
+// A clock input of the design and the peripherals that run on it. The clock is low from its
+// phase offset on and rises half a period later. The edges lie at exact fractions of the
+// period rounded down to ticks, so a period of no whole number of ticks does not drift.
+template <typename... Peripherals>
+class CClockDomain
+{
+    static_assert((std::is_base_of<CPeripheral<Peripherals>, Peripherals>::value && ...),
+            "peripherals derive from CPeripheral");
+
+    public:
+        // types
+        using Picoseconds = std::chrono::duration<int64_t, std::pico>;
+
+        // methods
+        CClockDomain(uint8_t &clock, uint64_t frequency, Peripherals &...peripherals)
+            : m_clock { clock }, m_frequency { frequency }, m_peripherals { peripherals... }
+        {
+        }
+
+        // delays all edges, before the domain is given to a scheduler
+        void setPhase(Picoseconds phase) { m_phase = phase; }
+
+        uint64_t getFrequency() const { return m_frequency; }
+
+        // time of an edge in ticks, the even edges fall and the odd ones rise
+        uint64_t getEdgeTime(uint64_t edge, uint64_t ticksPerSecond) const
+        {
+            // edge * ticksPerSecond / (2 * frequency) without overflowing the product
+            auto divisor = 2 * m_frequency;
+            return getPhaseTicks(ticksPerSecond) + edge * (ticksPerSecond / divisor)
+                + edge * (ticksPerSecond % divisor) / divisor;
+        }
+
+        // the first edge at or after the given time, e.g. of a restored simulation
+        uint64_t getFirstEdge(uint64_t time, uint64_t ticksPerSecond) const
+        {
+            auto phase = getPhaseTicks(ticksPerSecond);
+            if (time <= phase) return 0;
+
+            auto edge = static_cast<uint64_t>((time - phase) * (2.0L * m_frequency)
+                    / ticksPerSecond);
+            while ((edge > 0) && (getEdgeTime(edge - 1, ticksPerSecond) >= time)) --edge;
+            while (getEdgeTime(edge, ticksPerSecond) < time) ++edge;
+            return edge;
+        }
+
+        void setLevel(uint64_t edge) { m_clock = edge % 2; }
+
+        void drive() { forEach([](auto &peripheral) { peripheral.drive(); }); }
+
+        void edge(bool rising)
+        {
+            if (rising) forEach([](auto &peripheral) { peripheral.posedge(); });
+            else forEach([](auto &peripheral) { peripheral.negedge(); });
+        }
+
+        bool isFinished() const
+        {
+            return std::apply([](const auto &...peripherals)
+                    { return (peripherals.isFinished() || ...); }, m_peripherals);
+        }
+
+        void printStats(std::ostream &os) const
+        {
+            std::apply([&](const auto &...peripherals) { (peripherals.printStats(os), ...); },
+                    m_peripherals);
+        }
+
+    private:
+        // methods
+        uint64_t getPhaseTicks(uint64_t ticksPerSecond) const
+        {
+            return static_cast<uint64_t>(std::llround(m_phase.count()
+                        * static_cast<long double>(ticksPerSecond) / 1e12L));
+        }
+
+        template <typename Func>
+        void forEach(Func &&func)
+        {
+            std::apply([&](auto &...peripherals) { (func(peripherals), ...); }, m_peripherals);
+        }
+
+        // members
+        uint8_t &m_clock;
+        uint64_t m_frequency;
+        Picoseconds m_phase { 0 };
+        std::tuple<Peripherals &...> m_peripherals;
+};
+
+// Drives a verilated top with any number of clock domains of their own frequency and phase.
+// The next edge of every clock waits in a min-heap, bypassed for a single clock: the
+// scheduler advances the context time straight to the earliest one, sets the clocks with an
+// edge at that time, evaluates the model once for all of them and lets their peripherals
+// sample. The model is evaluated once per
+// distinct edge time and never in between. Between runs the context time is that of the next
+// edge, so a restored simulation continues with it.
+template <typename Top, typename... Domains>
+class CClockScheduler
+{
+    static_assert((sizeof...(Domains) > 0) && (sizeof...(Domains) <= 64),
+            "1 to 64 clock domains");
+
+    static constexpr bool singleClock = (sizeof...(Domains) == 1);
+
+    public:
+        // methods
+        CClockScheduler(VerilatedContext &context, Top &top, Domains &...domains)
+            : m_context { context }, m_top { top }, m_domains { domains... },
+            m_ticksPerSecond { ::getTicksPerSecond(context) }
+        {
+            forEachDomain(~uint64_t { 0 }, [&](auto &domain, size_t index)
+            {
+                auto frequency = domain.getFrequency();
+                if ((frequency == 0) || (frequency > m_ticksPerSecond / 2))
+                {
+                    std::cerr << "clock of " << frequency << " Hz does not fit the time "
+                        "precision of 1e" << context.timeprecision() << " s" << std::endl;
+                    m_valid = false;
+                    return;
+                }
+
+                auto edge = domain.getFirstEdge(context.time(), m_ticksPerSecond);
+                auto &step = m_steps[index];
+                step.edge = edge;
+                step.divisor = 2 * frequency;
+                step.ticks = m_ticksPerSecond / step.divisor;
+                step.remainder = m_ticksPerSecond % step.divisor;
+                step.error = edge * step.remainder % step.divisor;
+                step.time = domain.getEdgeTime(edge, m_ticksPerSecond);
+                if constexpr (!singleClock) m_queue.emplace(step.time, index);
+            });
+            if (m_valid) m_context.time(getNextTime());
+        }
+
+        bool isValid() const { return m_valid; }
+
+        uint64_t getTicksPerSecond() const { return m_ticksPerSecond; }
+
+        // Runs the edges before the given number of ticks from now, fewer if the design or a
+        // peripheral finishes. Returns the number of evaluations of the model.
+        uint64_t run(uint64_t ticks = std::numeric_limits<uint64_t>::max())
+        {
+            if (!m_valid) return 0;
+
+            auto now = m_context.time();
+            auto end = (ticks > std::numeric_limits<uint64_t>::max() - now)
+                ? std::numeric_limits<uint64_t>::max() : now + ticks;
+            uint64_t evaluations = 0;
+            while (getNextTime() < end)
+            {
+                auto time = getNextTime();
+                auto edges = popEdges(time);
+
+                m_context.time(time);
+                forEachDomain(edges, [&](auto &domain, size_t index)
+                {
+                    domain.drive();
+                    domain.setLevel(m_steps[index].edge);
+                });
+                m_top.eval();
+                forEachDomain(edges, [&](auto &domain, size_t index)
+                {
+                    domain.edge(m_steps[index].edge % 2);
+                    pushEdge(index);
+                    ++m_edgeCount;
+                });
+                ++evaluations;
+
+                m_context.time(getNextTime());
+                if (isFinished()) break;
+            }
+            m_evaluations += evaluations;
+            return evaluations;
+        }
+
+        bool isFinished() const
+        {
+            return !m_valid || m_context.gotFinish() || std::apply([](const auto &...domains)
+                    { return (domains.isFinished() || ...); }, m_domains);
+        }
+
+        void printStats(std::ostream &os) const
+        {
+            os << "clock scheduler: " << m_evaluations << " evaluations for " << m_edgeCount
+                << " edges\n";
+            std::apply([&](const auto &...domains) { (domains.printStats(os), ...); },
+                    m_domains);
+        }
+
+    private:
+        // types
+        using Edge = std::pair<uint64_t, size_t>;
+
+        // The next edge of a domain and its time. The time steps on by the whole ticks of half a
+        // period and carries the remainder, so it matches getEdgeTime without a division.
+        struct EdgeStep
+        {
+            uint64_t edge { 0 };
+            uint64_t time { 0 };
+            uint64_t ticks { 0 };
+            uint64_t remainder { 0 };
+            uint64_t divisor { 1 };
+            uint64_t error { 0 };
+
+            uint64_t next()
+            {
+                ++edge;
+                time += ticks;
+                error += remainder;
+                if (error >= divisor)
+                {
+                    error -= divisor;
+                    ++time;
+                }
+                return time;
+            }
+        };
+
+        // methods
+
+        // a single clock needs no heap, its next edge is the next event
+        uint64_t getNextTime() const
+        {
+            if constexpr (singleClock) return m_steps[0].time;
+            else return m_queue.top().first;
+        }
+
+        // the mask of the domains with an edge at the given time, taken off the heap
+        uint64_t popEdges(uint64_t time)
+        {
+            if constexpr (singleClock) return 1;
+
+            uint64_t edges = 0;
+            while (!m_queue.empty() && (m_queue.top().first == time))
+            {
+                edges |= uint64_t { 1 } << m_queue.top().second;
+                m_queue.pop();
+            }
+            return edges;
+        }
+
+        void pushEdge(size_t index)
+        {
+            auto time = m_steps[index].next();
+            if constexpr (!singleClock) m_queue.emplace(time, index);
+        }
+
+        // calls func(domain, index) for the domains with a bit set in the mask
+        template <typename Func>
+        void forEachDomain(uint64_t mask, Func &&func)
+        {
+            forEachDomain(mask, func, std::index_sequence_for<Domains...> {});
+        }
+
+        template <typename Func, size_t... Indices>
+        void forEachDomain(uint64_t mask, Func &func, std::index_sequence<Indices...>)
+        {
+            (forDomain<Indices>(mask, func), ...);
+        }
+
+        template <size_t Index, typename Func>
+        void forDomain(uint64_t mask, Func &func)
+        {
+            if (mask & (uint64_t { 1 } << Index)) func(std::get<Index>(m_domains), Index);
+        }
+
+        // members
+        VerilatedContext &m_context;
+        Top &m_top;
+        std::tuple<Domains &...> m_domains;
+        uint64_t m_ticksPerSecond;
+        bool m_valid { true };
+
+        EdgeStep m_steps[sizeof...(Domains)] {};
+        std::priority_queue<Edge, std::vector<Edge>, std::greater<Edge>> m_queue;
+
+        uint64_t m_evaluations { 0 };
+        uint64_t m_edgeCount { 0 };
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+
+#include "CTraceEvents.hpp"
+
+// Keeps simulated time in step with wall time. FREE_RUN never waits, REAL_TIME sleeps
+// whenever the simulation is ahead of the wall clock and SCALED does the same with simulated
+// time running factor times as fast as wall time. tick() is meant to be called on every
+// simulation tick but only looks at the clock once per check interval, e.g. once per line.
+class CPacer
+{
+    public:
+        // types
+        enum class Mode
+        {
+            FREE_RUN, REAL_TIME, SCALED
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        // methods
+        explicit CPacer(Mode mode = Mode::FREE_RUN, double factor = 1.0)
+            : m_mode { mode }, m_factor { (mode == Mode::SCALED) ? factor : 1.0 }
+        {
+        }
+
+        void setCheckInterval(uint64_t ticks)
+        {
+            m_interval = (ticks > 0) ? ticks : 1;
+            m_countdown = m_interval;
+        }
+
+        Mode getMode() const { return m_mode; }
+
+        void tick(std::chrono::nanoseconds simulated)
+        {
+            if (m_mode == Mode::FREE_RUN) return;
+            if (--m_countdown != 0) return;
+
+            m_countdown = m_interval;
+            pace(simulated);
+        }
+
+        // restarts pacing from the given simulated time, e.g. after a pause
+        void reset(std::chrono::nanoseconds simulated)
+        {
+            m_start = Clock::now();
+            m_simulatedStart = simulated;
+            m_started = true;
+        }
+
+        void pace(std::chrono::nanoseconds simulated)
+        {
+            if (!m_started)
+            {
+                reset(simulated);
+                return;
+            }
+
+            auto target = m_start + std::chrono::duration_cast<Clock::duration>(
+                    (simulated - m_simulatedStart) / m_factor);
+            auto now = Clock::now();
+            if (target > now)
+            {
+                VGA_TRACE_SCOPE("pace");
+                std::this_thread::sleep_until(target);
+            }
+            else if ((now - target) > m_maxLag)
+            {
+                // the simulation is too slow to keep up, do not race to catch up later
+                reset(simulated);
+            }
+        }
+
+    private:
+        // members
+        Mode m_mode;
+        double m_factor;
+        uint64_t m_interval { 1 };
+        uint64_t m_countdown { 1 };
+        bool m_started { false };
+        Clock::time_point m_start;
+        std::chrono::nanoseconds m_simulatedStart { 0 };
+        std::chrono::milliseconds m_maxLag { 100 };
+};
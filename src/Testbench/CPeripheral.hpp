@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ostream>
+#include <utility>
+
+// Base of the peripherals of a CClockDomain, which a CClockScheduler drives. The domain knows
+// the concrete type of each peripheral and calls its methods directly, so there is no virtual
+// call per edge: a peripheral defines the methods it needs and the defaults here inline to
+// nothing.
+template <typename Derived>
+class CPeripheral
+{
+    public:
+        // methods
+
+        // sets the design inputs the peripheral drives, before each evaluation of the model
+        void drive() {}
+
+        // samples the design outputs after the evaluation of a rising resp. falling clock edge
+        void posedge() {}
+        void negedge() {}
+
+        // whether the peripheral ends the simulation, checked after every evaluation
+        bool isFinished() const { return false; }
+
+        void printStats(std::ostream &) const {}
+
+    protected:
+        // methods
+        CPeripheral() = default;
+
+        Derived &derived() { return static_cast<Derived &>(*this); }
+        const Derived &derived() const { return static_cast<const Derived &>(*this); }
+};
+
+// A peripheral made of two callables, for testbench code that needs no class of its own:
+// drive() before and edge(rising) after every evaluation of the model.
+template <typename Drive, typename Edge>
+class CFunctionPeripheral : public CPeripheral<CFunctionPeripheral<Drive, Edge>>
+{
+    public:
+        // methods
+        CFunctionPeripheral(Drive drive, Edge edge)
+            : m_drive { std::move(drive) }, m_edge { std::move(edge) }
+        {
+        }
+
+        void drive() { m_drive(); }
+        void posedge() { m_edge(true); }
+        void negedge() { m_edge(false); }
+
+    private:
+        // members
+        Drive m_drive;
+        Edge m_edge;
+};
+
+template <typename Drive, typename Edge>
+inline CFunctionPeripheral<Drive, Edge> makePeripheral(Drive drive, Edge edge)
+{
+    return { std::move(drive), std::move(edge) };
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Statistical profiler of the phases of one simulation thread. The thread marks every phase
+// transition in a byte, a timer thread reads the byte periodically and counts the samples of
+// each phase. A mark is a relaxed store to a cache line no one writes to, so the marks can
+// stay in place when the profiler is not running. The period is not a round number, so it
+// does not beat with the frame rate.
+class CPhaseProfiler
+{
+    public:
+        // methods
+        explicit CPhaseProfiler(std::vector<std::string> phaseNames)
+            : m_names { std::move(phaseNames) }, m_samples(m_names.size(), 0)
+        {
+        }
+
+        ~CPhaseProfiler()
+        {
+            stop();
+        }
+
+        CPhaseProfiler(const CPhaseProfiler &) = delete;
+        CPhaseProfiler &operator=(const CPhaseProfiler &) = delete;
+
+        std::atomic<uint8_t> &getMarker() { return m_marker; }
+        void mark(uint8_t phase) { m_marker.store(phase, std::memory_order_relaxed); }
+
+        void start(std::chrono::microseconds period = std::chrono::microseconds { 1009 })
+        {
+            if (m_running.exchange(true)) return;
+
+            m_thread = std::thread { [this, period]
+                {
+                    auto next = std::chrono::steady_clock::now();
+                    while (m_running.load(std::memory_order_relaxed))
+                    {
+                        next += period;
+                        std::this_thread::sleep_until(next);
+
+                        // marks beyond the names count as the last phase
+                        size_t phase = m_marker.load(std::memory_order_relaxed);
+                        ++m_samples[std::min(phase, m_samples.size() - 1)];
+                    }
+                } };
+        }
+
+        void stop()
+        {
+            if (!m_running.exchange(false)) return;
+            m_thread.join();
+        }
+
+        // samples per phase, valid after stop()
+        const std::vector<size_t> &getSamples() const { return m_samples; }
+        const std::vector<std::string> &getPhaseNames() const { return m_names; }
+
+        // one line per phase with its samples and share, after stop()
+        void print(std::ostream &os) const
+        {
+            size_t total = 0;
+            for (auto samples : m_samples) total += samples;
+
+            os << "phase profile, " << total << " samples:\n";
+            for (size_t i = 0; i < m_names.size(); ++i)
+            {
+                double share = (total > 0) ? 100.0 * m_samples[i] / total : 0.0;
+                os << "    " << std::left << std::setw(16) << m_names[i] << std::right
+                    << std::setw(10) << m_samples[i] << std::fixed << std::setprecision(1)
+                    << std::setw(7) << share << " % " << std::string(share / 2.5, '#') << "\n";
+            }
+            os.flush();
+        }
+
+    private:
+        // members
+        std::vector<std::string> m_names;
+        std::vector<size_t> m_samples;
+        std::thread m_thread;
+        std::atomic<bool> m_running { false };
+
+        // written by the simulation thread only
+        alignas(64) std::atomic<uint8_t> m_marker { 0 };
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Declarative binding of the ports of a verilated top to the inputs of a peripheral. A port is
+// named once with TESTBENCH_PORT, CPort and CPortSlice select its bits and polarity, and a
+// CPinGroup concatenates them into one value, the first least significant. A peripheral takes
+// a group with one member per input. Everything is resolved at compile time: reading an input
+// compiles to the member loads, shifts and masks one would write by hand.
+
+// Declares Name as the accessor of the port member of every top that has one of that name,
+// whatever the model prefix. Verilator declares the ports as reference members, which rules
+// out pointers to members. The member may also be a path to a public signal of the design.
+#define TESTBENCH_PORT(Name, member) \
+    struct Name \
+    { \
+        template <typename Top> \
+        static const auto &get(const Top &top) { return top.member; } \
+    }
+
+constexpr uint64_t getBitMask(unsigned width)
+{
+    return (width >= 64) ? ~uint64_t { 0 } : (uint64_t { 1 } << width) - 1;
+}
+
+// A whole port of the given width, inverted for an active low signal. A port narrower than
+// its type is masked to its width like a slice, so it cannot spill into the next member. A
+// port as wide as its type has no bits to clear and a single bit port is 0 or 1 already, so
+// both read without a mask.
+template <typename Port, unsigned Width = 1, bool Inverted = false>
+class CPort
+{
+    static_assert((Width > 0) && (Width <= 64), "ports up to 64 bits");
+
+    public:
+        // members
+        static constexpr unsigned width = Width;
+
+        // methods
+        template <typename Top>
+        static uint64_t read(const Top &top)
+        {
+            using Value = std::decay_t<decltype(Port::get(top))>;
+            static_assert(std::is_integral<Value>::value, "ports of up to 64 bits");
+            static_assert(Width <= 8 * sizeof(Value), "width beyond the port");
+
+            constexpr bool masked = (Width > 1) && (Width < 8 * sizeof(Value));
+
+            uint64_t value = Port::get(top);
+            if constexpr (Inverted) value ^= getBitMask(Width);
+            if constexpr (masked) value &= getBitMask(Width);
+            return value;
+        }
+};
+
+// Width bits of a bus port from bit Lsb on, inverted for active low signals.
+template <typename Port, unsigned Lsb, unsigned Width = 1, bool Inverted = false>
+class CPortSlice
+{
+    static_assert((Width > 0) && (Lsb + Width <= 64), "slices of ports up to 64 bits");
+
+    public:
+        // members
+        static constexpr unsigned width = Width;
+
+        // methods
+        template <typename Top>
+        static uint64_t read(const Top &top)
+        {
+            using Value = std::decay_t<decltype(Port::get(top))>;
+            static_assert(std::is_integral<Value>::value, "ports of up to 64 bits");
+            static_assert(Lsb + Width <= 8 * sizeof(Value), "slice outside of the port");
+
+            uint64_t value = Port::get(top);
+            return ((Inverted ? ~value : value) >> Lsb) & getBitMask(Width);
+        }
+};
+
+// Ports, slices or other groups concatenated into one value, the first least significant.
+template <typename... Members>
+class CPinGroup
+{
+    static_assert(sizeof...(Members) > 0, "groups of at least one member");
+
+    public:
+        // types
+        template <size_t Index>
+        using Member = std::tuple_element_t<Index, std::tuple<Members...>>;
+
+        // members
+        static constexpr unsigned width = (Members::width + ...);
+        static_assert(width <= 64, "groups up to 64 bits");
+
+        // methods
+
+        // all members packed into one word
+        template <typename Top>
+        static uint64_t read(const Top &top)
+        {
+            return read(top, std::index_sequence_for<Members...> {});
+        }
+
+        // a single member, e.g. one input of a peripheral
+        template <size_t Index, typename Top>
+        static uint64_t get(const Top &top)
+        {
+            return Member<Index>::read(top);
+        }
+
+        // bit offset of a member in the packed word
+        static constexpr unsigned getOffset(size_t index)
+        {
+            constexpr unsigned widths[] = { Members::width... };
+            unsigned offset = 0;
+            for (size_t member = 0; member < index; ++member) offset += widths[member];
+            return offset;
+        }
+
+    private:
+        // methods
+        template <typename Top, size_t... Indices>
+        static uint64_t read(const Top &top, std::index_sequence<Indices...>)
+        {
+            return ((Members::read(top) << getOffset(Indices)) | ...);
+        }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CPinTraceWriter.hpp"
+
+// Read-only memory mapping of a pin trace file written by CPinTraceWriter. The samples are
+// used in place, so reading a trace costs no more than touching its pages.
+class CPinTraceReader
+{
+    public:
+        // methods
+        CPinTraceReader() = default;
+        CPinTraceReader(const CPinTraceReader &) = delete;
+        CPinTraceReader &operator=(const CPinTraceReader &) = delete;
+
+        ~CPinTraceReader()
+        {
+            close();
+        }
+
+        bool open(const std::string &fileName)
+        {
+            close();
+
+            int fd = ::open(fileName.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                std::cerr << "could not open pin trace file " << fileName << std::endl;
+                return false;
+            }
+
+            struct stat status;
+            if ((fstat(fd, &status) != 0) || (status.st_size < sizeof(PinTraceHeader)))
+            {
+                std::cerr << fileName << " is not a pin trace" << std::endl;
+                ::close(fd);
+                return false;
+            }
+
+            m_size = status.st_size;
+            m_mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (m_mapping == MAP_FAILED)
+            {
+                std::cerr << "could not map pin trace file " << fileName << std::endl;
+                m_mapping = nullptr;
+                return false;
+            }
+
+            std::memcpy(&m_header, m_mapping, sizeof(m_header));
+            if ((std::memcmp(m_header.magic, PinTraceHeader {}.magic, sizeof(m_header.magic)) != 0)
+                    || (m_header.version != 1) || (m_header.headerSize > m_size))
+            {
+                std::cerr << fileName << " is not a pin trace" << std::endl;
+                close();
+                return false;
+            }
+
+            // a recording that was not closed has no sample count, it ends with the file
+            m_samples = (m_size - m_header.headerSize) / sizeof(uint16_t);
+            if ((m_header.sampleCount != 0) && (m_header.sampleCount < m_samples))
+            {
+                m_samples = m_header.sampleCount;
+            }
+
+            // the samples are only read front to back
+            madvise(m_mapping, m_size, MADV_SEQUENTIAL);
+
+            return true;
+        }
+
+        void close()
+        {
+            if (m_mapping != nullptr) munmap(m_mapping, m_size);
+            m_mapping = nullptr;
+            m_size = 0;
+            m_samples = 0;
+        }
+
+        const PinTraceHeader &getHeader() const { return m_header; }
+
+        const uint16_t *data() const
+        {
+            return reinterpret_cast<const uint16_t *>(
+                static_cast<const char *>(m_mapping) + m_header.headerSize);
+        }
+
+        size_t size() const { return m_samples; }
+
+    private:
+        // members
+        void *m_mapping { nullptr };
+        size_t m_size { 0 };
+        size_t m_samples { 0 };
+        PinTraceHeader m_header;
+};
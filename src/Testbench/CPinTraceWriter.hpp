@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Header of a pin trace file. It is followed by sampleCount samples of 16 bit, one per sample
+// period, each holding up to 16 pins in native byte order. sampleCount is written when the
+// recording is closed and stays 0 if it never was.
+struct PinTraceHeader
+{
+    char magic[8] { 'P', 'I', 'N', 'T', 'R', 'A', 'C', 'E' };
+    uint32_t version { 1 };
+    uint32_t headerSize { 40 };
+    uint32_t mode { 0 };                // user defined, e.g. the video mode of the recorded signals
+    uint32_t pinCount { 0 };
+    uint64_t samplePeriodPs { 0 };
+    uint64_t sampleCount { 0 };
+};
+static_assert(sizeof(PinTraceHeader) == 40, "pin trace header layout");
+
+// Records up to 16 pins once per sample period into a pin trace file. Samples are collected
+// in a large buffer and written in blocks, so recording costs little more than a store.
+class CPinTraceWriter
+{
+    public:
+        // methods
+        explicit CPinTraceWriter(size_t bufferSamples = 1 << 20) : m_buffer(bufferSamples)
+        {
+        }
+
+        ~CPinTraceWriter()
+        {
+            close();
+        }
+
+        bool open(const std::string &fileName, uint32_t mode, uint32_t pinCount,
+                uint64_t samplePeriodPs)
+        {
+            close();
+
+            m_file.open(fileName, std::ios::binary | std::ios::trunc);
+            if (!m_file)
+            {
+                std::cerr << "could not open pin trace file " << fileName << std::endl;
+                return false;
+            }
+
+            m_header = PinTraceHeader {};
+            m_header.mode = mode;
+            m_header.pinCount = pinCount;
+            m_header.samplePeriodPs = samplePeriodPs;
+            m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+
+            return static_cast<bool>(m_file);
+        }
+
+        bool isOpen() const { return m_file.is_open(); }
+
+        void record(uint16_t pins)
+        {
+            m_buffer[m_fill++] = pins;
+            if (m_fill == m_buffer.size()) flush();
+        }
+
+        uint64_t getSampleCount() const { return m_header.sampleCount + m_fill; }
+
+        // writes the remaining samples and the final sample count
+        bool close()
+        {
+            if (!m_file.is_open()) return true;
+
+            flush();
+            m_file.seekp(0);
+            m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+            bool ok = static_cast<bool>(m_file);
+            m_file.close();
+
+            if (!ok) std::cerr << "writing the pin trace failed" << std::endl;
+            return ok;
+        }
+
+    private:
+        // methods
+        void flush()
+        {
+            m_file.write(reinterpret_cast<const char *>(m_buffer.data()),
+                    m_fill * sizeof(uint16_t));
+            m_header.sampleCount += m_fill;
+            m_fill = 0;
+        }
+
+        // members
+        std::ofstream m_file;
+        PinTraceHeader m_header;
+        std::vector<uint16_t> m_buffer;
+        size_t m_fill { 0 };
+};
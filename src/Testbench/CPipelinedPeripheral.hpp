@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+#include "CPeripheral.hpp"
+#include "CSpscRing.hpp"
+
+// The two rings between the simulation thread and a worker that consumes samples of the
+// design outputs: the samples go forward in order, inputs for the design come back. The
+// simulation only waits for the worker when the sample ring is full.
+template <typename Sample, typename Input = Sample>
+class CSamplePipe
+{
+    public:
+        // methods
+        explicit CSamplePipe(size_t capacity = 1 << 16, size_t inputCapacity = 256)
+            : m_samples { capacity }, m_inputs { inputCapacity }
+        {
+        }
+
+        // simulation side
+
+        // pushes a sample, waiting while the ring is full, false once the consumer is done
+        bool push(const Sample &sample)
+        {
+            if (!m_samples.push(sample))
+            {
+                ++m_stalls;
+                do
+                {
+                    if (isConsumerDone()) return false;
+                    std::this_thread::yield();
+                }
+                while (!m_samples.push(sample));
+            }
+            ++m_pushed;
+            return true;
+        }
+
+        // calls func with each input the consumer sent since the last call
+        template <typename Func>
+        void receive(Func &&func)
+        {
+            Input input;
+            while (m_inputs.pop(input)) func(input);
+        }
+
+        // waits until the consumer has taken all samples pushed so far, e.g. before a checkpoint
+        void synchronize() const
+        {
+            while ((m_consumed.load(std::memory_order_acquire) != m_pushed) && !isConsumerDone())
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        // no samples follow, the consumer returns once it has taken the remaining ones
+        void close() { m_closed.store(true, std::memory_order_release); }
+
+        bool isConsumerDone() const { return m_consumerDone.load(std::memory_order_acquire); }
+
+        uint64_t getPushed() const { return m_pushed; }
+        uint64_t getStalls() const { return m_stalls; }
+
+        // worker side
+
+        // Hands the samples to func in order until it returns false or the pipe is closed. The
+        // count for synchronize() is published every publishInterval samples and whenever the
+        // ring runs empty, so it stays off the simulation's cache lines in between.
+        template <typename Func>
+        void consume(Func &&func)
+        {
+            Sample sample;
+            uint64_t consumed = 0;
+            while (true)
+            {
+                if (!m_samples.pop(sample))
+                {
+                    m_consumed.store(consumed, std::memory_order_release);
+
+                    // a sample pushed before closing is in the ring once the close is seen
+                    if (!m_closed.load(std::memory_order_acquire))
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    if (!m_samples.pop(sample)) break;
+                }
+
+                auto more = func(sample);
+                if (++consumed % publishInterval == 0)
+                {
+                    m_consumed.store(consumed, std::memory_order_release);
+                }
+                if (!more) break;
+            }
+            m_consumed.store(consumed, std::memory_order_release);
+            m_consumerDone.store(true, std::memory_order_release);
+        }
+
+        // sends an input back to the simulation, false if the back channel is full
+        bool send(const Input &input) { return m_inputs.push(input); }
+
+    private:
+        // members
+        static constexpr uint64_t publishInterval = 256;
+
+        CSpscRing<Sample> m_samples;
+        CSpscRing<Input> m_inputs;
+
+        // simulation
+        uint64_t m_pushed { 0 };
+        uint64_t m_stalls { 0 };
+
+        // each flag on a line of its own, polled by the other thread
+        alignas(64) std::atomic<bool> m_closed { false };
+        alignas(64) std::atomic<bool> m_consumerDone { false };
+
+        // worker, written once per publishInterval samples
+        alignas(64) std::atomic<uint64_t> m_consumed { 0 };
+};
+
+// The simulation side of a CSamplePipe as a peripheral. It takes a sample with the sampler
+// after each rising edge, or after both edges, and applies the inputs that came back with the
+// driver before every syncInterval-th evaluation, so a worker that drives the design does so
+// at these coarse points only. It finishes when the consumer is done, which is up to a ring
+// of samples after the design produced the sample that decided it.
+template <typename Pipe, typename Sampler, typename Driver>
+class CPipelinedPeripheral : public CPeripheral<CPipelinedPeripheral<Pipe, Sampler, Driver>>
+{
+    public:
+        // methods
+        CPipelinedPeripheral(Pipe &pipe, Sampler sampler, Driver driver, bool bothEdges = false,
+                uint64_t syncInterval = 1024)
+            : m_pipe { pipe }, m_sampler { std::move(sampler) }, m_driver { std::move(driver) },
+            m_bothEdges { bothEdges }, m_syncInterval { (syncInterval > 0) ? syncInterval : 1 },
+            m_countdown { m_syncInterval }
+        {
+        }
+
+        Pipe &getPipe() { return m_pipe; }
+
+        void drive()
+        {
+            if (--m_countdown != 0) return;
+
+            m_countdown = m_syncInterval;
+            m_pipe.receive(m_driver);
+        }
+
+        void posedge() { m_pipe.push(m_sampler()); }
+
+        void negedge()
+        {
+            if (m_bothEdges) m_pipe.push(m_sampler());
+        }
+
+        bool isFinished() const { return m_pipe.isConsumerDone(); }
+
+        void printStats(std::ostream &os) const
+        {
+            os << "pipeline: " << m_pipe.getPushed() << " samples, waited for the consumer "
+                << m_pipe.getStalls() << " times\n";
+        }
+
+    private:
+        // members
+        Pipe &m_pipe;
+        Sampler m_sampler;
+        Driver m_driver;
+        bool m_bothEdges;
+        uint64_t m_syncInterval;
+        uint64_t m_countdown;
+};
+
+template <typename Pipe, typename Sampler, typename Driver>
+inline CPipelinedPeripheral<Pipe, Sampler, Driver> makePipelinedPeripheral(Pipe &pipe,
+        Sampler sampler, Driver driver, bool bothEdges = false, uint64_t syncInterval = 1024)
+{
+    return { pipe, std::move(sampler), std::move(driver), bothEdges, syncInterval };
+}
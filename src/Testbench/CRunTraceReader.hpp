@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CRunTraceWriter.hpp"
+
+// Read-only memory mapping of a run trace file written by CRunTraceWriter. The runs and the
+// frame index are used in place, the line gaps are summed up to line starts once; the index
+// gives random access to frames and lines.
+class CRunTraceReader
+{
+    public:
+        // methods
+        CRunTraceReader() = default;
+        CRunTraceReader(const CRunTraceReader &) = delete;
+        CRunTraceReader &operator=(const CRunTraceReader &) = delete;
+
+        ~CRunTraceReader()
+        {
+            close();
+        }
+
+        // whether the file starts like a run trace, to tell it from other trace formats
+        static bool isRunTrace(const std::string &fileName)
+        {
+            char magic[sizeof(RunTraceHeader::magic)] {};
+            std::ifstream file { fileName, std::ios::binary };
+            file.read(magic, sizeof(magic));
+            return std::memcmp(magic, RunTraceHeader {}.magic, sizeof(magic)) == 0;
+        }
+
+        bool open(const std::string &fileName)
+        {
+            close();
+
+            int fd = ::open(fileName.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                std::cerr << "could not open run trace file " << fileName << std::endl;
+                return false;
+            }
+
+            struct stat status;
+            if ((fstat(fd, &status) != 0)
+                    || (static_cast<size_t>(status.st_size) < sizeof(RunTraceHeader)))
+            {
+                std::cerr << fileName << " is not a run trace" << std::endl;
+                ::close(fd);
+                return false;
+            }
+
+            m_size = status.st_size;
+            m_mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (m_mapping == MAP_FAILED)
+            {
+                std::cerr << "could not map run trace file " << fileName << std::endl;
+                m_mapping = nullptr;
+                return false;
+            }
+
+            std::memcpy(&m_header, m_mapping, sizeof(m_header));
+            if ((std::memcmp(m_header.magic, RunTraceHeader {}.magic, sizeof(m_header.magic)) != 0)
+                    || (m_header.version != 2) || (m_header.headerSize > m_size))
+            {
+                std::cerr << fileName << " is not a run trace" << std::endl;
+                close();
+                return false;
+            }
+
+            // a recording that was not closed has neither counts nor index, it ends with the file
+            size_t available = (m_size - m_header.headerSize) / sizeof(uint32_t);
+            m_runs = m_header.runCount;
+            if ((m_runs == 0) || (m_runs > available))
+            {
+                m_runs = available;
+                m_header.lineCount = 0;
+                m_header.frameCount = 0;
+            }
+            size_t indexOffset = m_header.headerSize + (m_runs + (m_runs & 1)) * sizeof(uint32_t);
+            size_t frameOffset = indexOffset + (m_header.lineCount + 3) / 4 * sizeof(uint64_t);
+            if (frameOffset + m_header.frameCount * sizeof(RunIndexEntry) > m_size)
+            {
+                m_header.lineCount = 0;
+                m_header.frameCount = 0;
+            }
+            m_frameIndex = reinterpret_cast<const RunIndexEntry *>(
+                static_cast<const char *>(m_mapping) + frameOffset);
+
+            auto gaps = reinterpret_cast<const uint16_t *>(
+                static_cast<const char *>(m_mapping) + indexOffset);
+            uint64_t line = 0;
+            for (size_t i = 0; i < m_header.lineCount; ++i)
+            {
+                line += gaps[i];
+                if (gaps[i] != 0xffff) m_lineStarts.push_back(line);
+            }
+
+            if (m_header.sampleCount == 0)
+            {
+                for (size_t i = 0; i < m_runs; ++i) m_header.sampleCount += data()[i] >> 16;
+            }
+
+            return true;
+        }
+
+        void close()
+        {
+            if (m_mapping != nullptr) munmap(m_mapping, m_size);
+            m_mapping = nullptr;
+            m_size = 0;
+            m_runs = 0;
+            m_lineStarts.clear();
+        }
+
+        const RunTraceHeader &getHeader() const { return m_header; }
+
+        const uint32_t *data() const
+        {
+            return reinterpret_cast<const uint32_t *>(
+                static_cast<const char *>(m_mapping) + m_header.headerSize);
+        }
+
+        size_t size() const { return m_runs; }
+
+        // the index in the order of the trace, empty if the recording has none; a line is given
+        // by the run that starts with its sync edge
+        const uint64_t *getLineIndex() const { return m_lineStarts.data(); }
+        size_t getLineCount() const { return m_lineStarts.size(); }
+        const RunIndexEntry *getFrameIndex() const { return m_frameIndex; }
+        size_t getFrameCount() const { return m_header.frameCount; }
+
+    private:
+        // members
+        void *m_mapping { nullptr };
+        size_t m_size { 0 };
+        size_t m_runs { 0 };
+        const RunIndexEntry *m_frameIndex { nullptr };
+        std::vector<uint64_t> m_lineStarts;
+        RunTraceHeader m_header;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Header of a run trace file. It is followed by runCount runs of 32 bit, each holding up to
+// 16 pins in its low half and the number of sample periods they held in its high half, padded
+// to a multiple of 8 bytes. The falling edges of pin 0 and pin 1, the syncs of the vga pin
+// layout, are indexed after them: lineCount line starts of 16 bit, each the number of runs
+// since the one before, where 0xffff carries a longer gap over to the next entry, padded to a
+// multiple of 8 bytes, then frameCount frame starts. The counts are written when the recording
+// is closed and stay 0 if it never was.
+struct RunTraceHeader
+{
+    char magic[8] { 'R', 'U', 'N', 'T', 'R', 'A', 'C', 'E' };
+    uint32_t version { 2 };
+    uint32_t headerSize { 64 };
+    uint32_t mode { 0 };                // user defined, e.g. the video mode of the recorded signals
+    uint32_t pinCount { 0 };
+    uint64_t samplePeriodPs { 0 };
+    uint64_t sampleCount { 0 };
+    uint64_t runCount { 0 };
+    uint64_t lineCount { 0 };
+    uint64_t frameCount { 0 };
+};
+static_assert(sizeof(RunTraceHeader) == 64, "run trace header layout");
+
+// a frame start: the run that starts with the sync edge and its first sample
+struct RunIndexEntry
+{
+    uint64_t run;
+    uint64_t sample;
+};
+
+// Records up to 16 pins once per sample period into a run trace file. Equal samples extend the
+// current run, so blanking and flat colors take a few bytes per line instead of 2 per sample.
+class CRunTraceWriter
+{
+    public:
+        // methods
+        explicit CRunTraceWriter(size_t bufferRuns = 1 << 16) : m_buffer(bufferRuns)
+        {
+        }
+
+        ~CRunTraceWriter()
+        {
+            close();
+        }
+
+        // the frame index is always written, the larger line index on request
+        bool open(const std::string &fileName, uint32_t mode, uint32_t pinCount,
+                uint64_t samplePeriodPs, bool indexLines)
+        {
+            close();
+
+            m_file.open(fileName, std::ios::binary | std::ios::trunc);
+            if (!m_file)
+            {
+                std::cerr << "could not open run trace file " << fileName << std::endl;
+                return false;
+            }
+
+            m_header = RunTraceHeader {};
+            m_header.mode = mode;
+            m_header.pinCount = pinCount;
+            m_header.samplePeriodPs = samplePeriodPs;
+            m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+
+            m_indexLines = indexLines;
+            m_lineIndex.clear();
+            m_lastLine = 0;
+            m_frameIndex.clear();
+            m_length = 0;
+
+            return static_cast<bool>(m_file);
+        }
+
+        bool isOpen() const { return m_file.is_open(); }
+
+        void record(uint16_t pins)
+        {
+            if ((pins == m_pins) && (m_length > 0) && (m_length < 0xffff))
+            {
+                ++m_length;
+                return;
+            }
+
+            if (m_length > 0)
+            {
+                RunIndexEntry start { m_header.runCount + m_fill + 1,
+                    m_header.sampleCount + m_length };
+                if (m_indexLines && (m_pins & 1) && !(pins & 1)) indexLine(start.run);
+                if ((m_pins & 2) && !(pins & 2)) m_frameIndex.push_back(start);
+                append();
+            }
+            m_pins = pins;
+            m_length = 1;
+        }
+
+        uint64_t getSampleCount() const { return m_header.sampleCount + m_length; }
+
+        // writes the remaining runs, the index and the final counts
+        bool close()
+        {
+            if (!m_file.is_open()) return true;
+
+            if (m_length > 0) append();
+            flush();
+
+            uint64_t padding = 0;
+            m_file.write(reinterpret_cast<const char *>(&padding), (m_header.runCount & 1) * 4);
+            m_file.write(reinterpret_cast<const char *>(m_lineIndex.data()),
+                    m_lineIndex.size() * sizeof(uint16_t));
+            m_file.write(reinterpret_cast<const char *>(&padding),
+                    (4 - m_lineIndex.size() % 4) % 4 * sizeof(uint16_t));
+            m_file.write(reinterpret_cast<const char *>(m_frameIndex.data()),
+                    m_frameIndex.size() * sizeof(RunIndexEntry));
+            m_header.lineCount = m_lineIndex.size();
+            m_header.frameCount = m_frameIndex.size();
+
+            m_file.seekp(0);
+            m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+            bool ok = static_cast<bool>(m_file);
+            m_file.close();
+
+            if (!ok) std::cerr << "writing the run trace failed" << std::endl;
+            return ok;
+        }
+
+    private:
+        // methods
+        void append()
+        {
+            m_buffer[m_fill++] = m_pins | (static_cast<uint32_t>(m_length) << 16);
+            m_header.sampleCount += m_length;
+            m_length = 0;
+            if (m_fill == m_buffer.size()) flush();
+        }
+
+        // the line index stores gaps, a frame of 525 lines takes about 1 KB
+        void indexLine(uint64_t run)
+        {
+            uint64_t gap = run - m_lastLine;
+            for (; gap >= 0xffff; gap -= 0xffff) m_lineIndex.push_back(0xffff);
+            m_lineIndex.push_back(static_cast<uint16_t>(gap));
+            m_lastLine = run;
+        }
+
+        void flush()
+        {
+            m_file.write(reinterpret_cast<const char *>(m_buffer.data()),
+                    m_fill * sizeof(uint32_t));
+            m_header.runCount += m_fill;
+            m_fill = 0;
+        }
+
+        // members
+        std::ofstream m_file;
+        RunTraceHeader m_header;
+        std::vector<uint32_t> m_buffer;
+        size_t m_fill { 0 };
+        uint16_t m_pins { 0 };
+        size_t m_length { 0 };
+        bool m_indexLines { false };
+        std::vector<uint16_t> m_lineIndex;
+        uint64_t m_lastLine { 0 };
+        std::vector<RunIndexEntry> m_frameIndex;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Bounded ring of the last value changes of up to 32 single-bit signals. Recording a sample
+// that did not change anything is a single compare, so it can run on every simulation tick
+// while full waveform tracing is off.
+class CSignalHistory
+{
+    public:
+        // methods
+        CSignalHistory(std::vector<std::string> names, size_t capacity)
+            : m_names { std::move(names) }, m_ring(capacity)
+        {
+        }
+
+        void record(uint64_t time, uint32_t values)
+        {
+            if ((m_size > 0) && (values == m_last)) return;
+
+            m_ring[m_head] = { time, values };
+            m_head = (m_head + 1) % m_ring.size();
+            if (m_size < m_ring.size()) ++m_size;
+            m_last = values;
+        }
+
+        void clear()
+        {
+            m_head = 0;
+            m_size = 0;
+        }
+
+        size_t size() const { return m_size; }
+
+        // write the recorded changes as a VCD file, oldest first
+        bool writeVcd(const std::string &fileName, const std::string &timescale = "1ns") const
+        {
+            std::ofstream file { fileName };
+            if (!file)
+            {
+                std::cerr << "could not open signal history file " << fileName << std::endl;
+                return false;
+            }
+
+            file << "$timescale " << timescale << " $end\n";
+            file << "$scope module history $end\n";
+            for (size_t i = 0; i < m_names.size(); ++i)
+            {
+                file << "$var wire 1 " << identifier(i) << " " << m_names[i] << " $end\n";
+            }
+            file << "$upscope $end\n$enddefinitions $end\n";
+
+            size_t tail = (m_head + m_ring.size() - m_size) % m_ring.size();
+            for (size_t n = 0; n < m_size; ++n)
+            {
+                const auto &entry = m_ring[(tail + n) % m_ring.size()];
+                const auto &previous = m_ring[(tail + n + m_ring.size() - 1) % m_ring.size()];
+
+                file << "#" << entry.time << "\n";
+                for (size_t i = 0; i < m_names.size(); ++i)
+                {
+                    bool value = (entry.values >> i) & 1;
+                    if ((n == 0) || (value != (((previous.values) >> i) & 1)))
+                    {
+                        file << (value ? '1' : '0') << identifier(i) << "\n";
+                    }
+                }
+            }
+
+            return static_cast<bool>(file);
+        }
+
+    private:
+        // types
+        struct Entry
+        {
+            uint64_t time;
+            uint32_t values;
+        };
+
+        // methods
+        static std::string identifier(size_t index)
+        {
+            return std::string(1, static_cast<char>('!' + index));
+        }
+
+        // members
+        std::vector<std::string> m_names;
+        std::vector<Entry> m_ring;
+        size_t m_head { 0 };
+        size_t m_size { 0 };
+        uint32_t m_last { 0 };
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+
+// Lock-free ring buffer between exactly one producer and one consumer thread. Each side
+// keeps a cached copy of the other side's index and only reloads the shared atomic when the
+// ring looks full or empty, so a push or pop usually touches no shared cache line.
+template <typename T>
+class CSpscRing
+{
+    public:
+        // methods
+        explicit CSpscRing(size_t capacity)
+        {
+            size_t size = 1;
+            while (size < capacity) size <<= 1;
+
+            m_buffer.resize(size);
+            m_mask = size - 1;
+        }
+
+        size_t capacity() const { return m_buffer.size(); }
+
+        // producer side, false if the ring is full
+        bool push(const T &value)
+        {
+            auto head = m_head.load(std::memory_order_relaxed);
+            if ((head - m_cachedTail) == m_buffer.size())
+            {
+                m_cachedTail = m_tail.load(std::memory_order_acquire);
+                if ((head - m_cachedTail) == m_buffer.size()) return false;
+            }
+
+            m_buffer[head & m_mask] = value;
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side, false if the ring is empty
+        bool pop(T &value)
+        {
+            auto tail = m_tail.load(std::memory_order_relaxed);
+            if (tail == m_cachedHead)
+            {
+                m_cachedHead = m_head.load(std::memory_order_acquire);
+                if (tail == m_cachedHead) return false;
+            }
+
+            value = m_buffer[tail & m_mask];
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const
+        {
+            return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+        }
+
+    private:
+        // members
+        std::vector<T> m_buffer;
+        size_t m_mask { 0 };
+
+        // producer
+        alignas(64) std::atomic<size_t> m_head { 0 };
+        size_t m_cachedTail { 0 };
+
+        // consumer
+        alignas(64) std::atomic<size_t> m_tail { 0 };
+        size_t m_cachedHead { 0 };
+};
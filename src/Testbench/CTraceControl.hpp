@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "CSignalHistory.hpp"
+
+// Decides on which simulation ticks a Verilated tracer dumps. Nothing is traced unless a
+// window is set or a trigger fires. Tracing is active where the time and frame windows
+// overlap and for a fixed time after a trigger, which also writes the pre-trigger signal
+// history to its own file. Ticks outside of all of them only cost the window comparisons.
+template <typename Tracer>
+class CTraceControl
+{
+    public:
+        // methods
+        explicit CTraceControl(Tracer &tracer) : m_tracer { tracer } {}
+
+        void setTimeWindow(uint64_t start, uint64_t stop)
+        {
+            m_windowEnabled = true;
+            m_windowStart = start;
+            m_windowStop = stop;
+        }
+
+        void setFrameWindow(size_t first, size_t last)
+        {
+            m_windowEnabled = true;
+            m_firstFrame = first;
+            m_lastFrame = last;
+        }
+
+        // The first trigger after arming traces for postTriggerTime and, if a history is
+        // given, writes the signal changes leading up to it to historyFileName, with the times
+        // in units of historyTimescale.
+        void arm(uint64_t postTriggerTime, CSignalHistory *history = nullptr,
+                const std::string &historyFileName = "",
+                const std::string &historyTimescale = "1ns")
+        {
+            m_armed = true;
+            m_postTriggerTime = postTriggerTime;
+            m_history = history;
+            m_historyFileName = historyFileName;
+            m_historyTimescale = historyTimescale;
+        }
+
+        void trigger(uint64_t time)
+        {
+            if (!m_armed) return;
+
+            m_armed = false;
+            m_triggerEnd = time + m_postTriggerTime;
+            if (m_history) m_history->writeVcd(m_historyFileName, m_historyTimescale);
+        }
+
+        // frame index used for the frame window, e.g. the monitor's frame counter
+        void setFrame(size_t frame) { m_frame = frame; }
+
+        bool isActive(uint64_t time) const
+        {
+            return (m_windowEnabled && (time >= m_windowStart) && (time < m_windowStop)
+                    && (m_frame >= m_firstFrame) && (m_frame <= m_lastFrame))
+                || (time < m_triggerEnd);
+        }
+
+        void dump(uint64_t time)
+        {
+            if (isActive(time)) m_tracer.dump(time);
+        }
+
+    private:
+        // members
+        Tracer &m_tracer;
+
+        bool m_windowEnabled { false };
+        uint64_t m_windowStart { 0 };
+        uint64_t m_windowStop { std::numeric_limits<uint64_t>::max() };
+        size_t m_firstFrame { 0 };
+        size_t m_lastFrame { std::numeric_limits<size_t>::max() };
+        size_t m_frame { 0 };
+
+        bool m_armed { false };
+        uint64_t m_postTriggerTime { 0 };
+        uint64_t m_triggerEnd { 0 };
+        CSignalHistory *m_history { nullptr };
+        std::string m_historyFileName;
+        std::string m_historyTimescale;
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Begin and end times of phases of the simulation and the render path, written as Chrome
+// trace-event JSON for Perfetto or chrome://tracing. Only built with VGA_TRACE_EVENTS: without
+// it enabled is false, the code in if constexpr (CTraceEvents::enabled) is discarded and
+// VGA_TRACE_SCOPE expands to nothing.
+//
+// Each thread records into its own buffer of fixed capacity without locks; the mutex is only
+// taken when a thread records its first event and when writing. Events beyond the capacity are
+// dropped and counted. Names have to be string literals, they are stored as pointers.
+class CTraceEvents
+{
+    public:
+        // types
+        using Clock = std::chrono::steady_clock;
+
+#ifdef VGA_TRACE_EVENTS
+        static constexpr bool enabled = true;
+#else
+        static constexpr bool enabled = false;
+#endif
+
+        // methods
+        static void record(const char *name, Clock::time_point begin, Clock::time_point end)
+        {
+            if (!enabled) return;
+
+            auto &buffer = getThreadBuffer();
+            auto count = buffer.count.load(std::memory_order_relaxed);
+            if (count == buffer.capacity)
+            {
+                ++buffer.dropped;
+                return;
+            }
+
+            buffer.events[count] = { name, begin.time_since_epoch().count(),
+                end.time_since_epoch().count() };
+            buffer.count.store(count + 1, std::memory_order_release);
+        }
+
+        // the name of the calling thread in the trace, a string literal
+        static void setThreadName(const char *name)
+        {
+            if (enabled) getThreadBuffer().name = name;
+        }
+
+        // capacity of the buffers of threads that have not recorded yet
+        static void setCapacity(size_t events)
+        {
+            std::lock_guard<std::mutex> lock { getRegistry().mutex };
+            getRegistry().capacity = events;
+        }
+
+        // writes the events recorded so far, e.g. at exit
+        static bool write(const std::string &fileName)
+        {
+            if (!enabled)
+            {
+                std::cerr << "trace events need a build with VGA_TRACE_EVENTS" << std::endl;
+                return false;
+            }
+
+            std::ofstream file { fileName };
+            if (!file)
+            {
+                std::cerr << "could not open trace event file " << fileName << std::endl;
+                return false;
+            }
+
+            auto &registry = getRegistry();
+            std::lock_guard<std::mutex> lock { registry.mutex };
+
+            // timestamps in microseconds from the first event
+            auto origin = std::numeric_limits<Clock::rep>::max();
+            for (const auto &buffer : registry.buffers)
+            {
+                auto count = buffer->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    origin = std::min(origin, buffer->events[i].begin);
+                }
+            }
+            auto micros = [&](Clock::rep ticks)
+                {
+                    return std::chrono::duration<double, std::micro>(Clock::duration { ticks })
+                        .count();
+                };
+
+            file << "{\"traceEvents\":[\n" << std::fixed << std::setprecision(3);
+            const char *separator = "";
+            size_t dropped = 0;
+            for (size_t tid = 0; tid < registry.buffers.size(); ++tid)
+            {
+                const auto &buffer = *registry.buffers[tid];
+                file << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                    << tid << ",\"args\":{\"name\":\"" << buffer.name << "\"}}";
+                separator = ",\n";
+
+                auto count = buffer.count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const auto &event = buffer.events[i];
+                    file << separator << "{\"name\":\"" << event.name
+                        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"ts\":"
+                        << micros(event.begin - origin) << ",\"dur\":"
+                        << micros(event.end - event.begin) << "}";
+                }
+                dropped += buffer.dropped;
+            }
+            file << "\n],\"displayTimeUnit\":\"ns\"}" << std::endl;
+
+            if (dropped > 0)
+            {
+                std::cerr << dropped << " trace events dropped, the buffers were full" << std::endl;
+            }
+            return static_cast<bool>(file);
+        }
+
+    private:
+        // types
+        // plain ticks, so that a new buffer is not written until it is used
+        struct Event
+        {
+            const char *name;
+            Clock::rep begin;
+            Clock::rep end;
+        };
+
+        // written by its thread only, read by write() up to the published count
+        struct Buffer
+        {
+            explicit Buffer(size_t size) : events { new Event[size] }, capacity { size } {}
+
+            std::unique_ptr<Event[]> events;
+            size_t capacity;
+            std::atomic<size_t> count { 0 };
+            size_t dropped { 0 };
+            const char *name { "thread" };
+        };
+
+        // the buffers outlive their threads, so that they can be written after joining them
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<Buffer>> buffers;
+            size_t capacity { 1 << 20 };
+        };
+
+        // methods
+        static Registry &getRegistry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        static Buffer &getThreadBuffer()
+        {
+            thread_local Buffer *buffer = nullptr;
+            if (buffer == nullptr)
+            {
+                auto &registry = getRegistry();
+                std::lock_guard<std::mutex> lock { registry.mutex };
+                registry.buffers.emplace_back(new Buffer { registry.capacity });
+                buffer = registry.buffers.back().get();
+            }
+            return *buffer;
+        }
+};
+
+// records the enclosing scope as an event of the given name
+class CTraceScope
+{
+    public:
+        // methods
+        explicit CTraceScope(const char *name)
+            : m_name { name }, m_begin { CTraceEvents::Clock::now() }
+        {
+        }
+
+        ~CTraceScope()
+        {
+            CTraceEvents::record(m_name, m_begin, CTraceEvents::Clock::now());
+        }
+
+        CTraceScope(const CTraceScope &) = delete;
+        CTraceScope &operator=(const CTraceScope &) = delete;
+
+    private:
+        // members
+        const char *m_name;
+        CTraceEvents::Clock::time_point m_begin;
+};
+
+#ifdef VGA_TRACE_EVENTS
+#define VGA_TRACE_CONCAT_(a, b) a##b
+#define VGA_TRACE_CONCAT(a, b) VGA_TRACE_CONCAT_(a, b)
+#define VGA_TRACE_SCOPE(name) CTraceScope VGA_TRACE_CONCAT(traceScope, __LINE__) { name }
+#else
+#define VGA_TRACE_SCOPE(name)
+#endif
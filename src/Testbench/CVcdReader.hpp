@@ -0,0 +1,324 @@
+#pragma once
+
+#include <cstdlib>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Streaming reader of value change dump files. The file is parsed in fixed size blocks, so
+// dumps of any size are read with bounded memory. Selected signals are mapped onto the bits of
+// a 32 bit word and read() reports that word whenever it changed, with the time of the change.
+class CVcdReader
+{
+    public:
+        // types
+        struct Variable
+        {
+            std::string name;           // hierarchical, scopes separated by dots
+            std::string identifier;
+            size_t width { 1 };
+        };
+
+        // methods
+        explicit CVcdReader(size_t blockSize = 1 << 20) : m_buffer(blockSize)
+        {
+        }
+
+        bool open(const std::string &fileName)
+        {
+            m_file.open(fileName, std::ios::binary);
+            if (!m_file)
+            {
+                std::cerr << "could not open vcd file " << fileName << std::endl;
+                return false;
+            }
+
+            return true;
+        }
+
+        // reads the declarations up to $enddefinitions
+        bool readHeader()
+        {
+            std::vector<std::string> scopes;
+            std::string token;
+            while (nextToken(token))
+            {
+                if (token == "$scope")
+                {
+                    std::string type;
+                    std::string name;
+                    nextToken(type);
+                    nextToken(name);
+                    scopes.push_back(name);
+                    skipToEnd();
+                }
+                else if (token == "$upscope")
+                {
+                    if (!scopes.empty()) scopes.pop_back();
+                    skipToEnd();
+                }
+                else if (token == "$var")
+                {
+                    std::string type;
+                    std::string width;
+                    Variable variable;
+                    nextToken(type);
+                    nextToken(width);
+                    nextToken(variable.identifier);
+                    nextToken(variable.name);
+                    variable.width = std::strtoul(width.c_str(), nullptr, 10);
+                    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope)
+                    {
+                        variable.name = *scope + "." + variable.name;
+                    }
+                    m_variables.push_back(variable);
+                    skipToEnd();
+                }
+                else if (token == "$timescale")
+                {
+                    std::string timescale;
+                    while (nextToken(token) && (token != "$end"))
+                    {
+                        timescale += token;
+                    }
+                    if (!parseTimescale(timescale)) return false;
+                }
+                else if (token == "$enddefinitions")
+                {
+                    skipToEnd();
+                    return true;
+                }
+                else if (token[0] == '$')
+                {
+                    // $date, $version, $comment and others
+                    skipToEnd();
+                }
+            }
+
+            std::cerr << "vcd file ends before $enddefinitions" << std::endl;
+            return false;
+        }
+
+        const std::vector<Variable> &getVariables() const { return m_variables; }
+
+        // picoseconds per time unit of the dump
+        uint64_t getTimescalePs() const { return m_timescalePs; }
+
+        // Maps a signal onto the bits from bit on, a vector with its least significant bit first.
+        // The name is matched against the end of the hierarchical names, so it may be qualified
+        // with as many scopes as needed to make it unique; the first match is taken. Returns the
+        // width of the signal or 0 if there is none.
+        size_t mapSignal(const std::string &name, unsigned bit)
+        {
+            for (const auto &variable : m_variables)
+            {
+                bool matches = (variable.name == name)
+                    || ((variable.name.size() > name.size())
+                        && (variable.name.compare(variable.name.size() - name.size(), name.size(),
+                            name) == 0)
+                        && (variable.name[variable.name.size() - name.size() - 1] == '.'));
+                if (!matches) continue;
+
+                if (bit + variable.width > 32)
+                {
+                    std::cerr << "signal " << name << " does not fit into 32 bits" << std::endl;
+                    return 0;
+                }
+                m_mapping[encode(variable.identifier)].push_back({ bit, variable.width });
+                return variable.width;
+            }
+
+            std::cerr << "signal " << name << " not found in vcd file" << std::endl;
+            return 0;
+        }
+
+        // Reads the value changes to the end of the file. onChange(time, values) is called
+        // whenever the mapped signals changed, with the values they held at the end of the time
+        // step; x and z read as 0.
+        template <typename Callback>
+        bool read(Callback &&onChange)
+        {
+            uint32_t values = 0;
+            uint32_t reported = 0;
+            bool hasReported = false;
+            bool hasValues = false;
+            uint64_t time = 0;
+
+            // the values of the first time step are always reported
+            auto report = [&]()
+                {
+                    if (hasReported && (values == reported)) return;
+
+                    onChange(time, values);
+                    reported = values;
+                    hasReported = true;
+                };
+
+            std::string token;
+            while (nextToken(token))
+            {
+                switch (token[0])
+                {
+                    case '#':
+                        if (hasValues) report();
+                        hasValues = false;
+                        time = std::strtoull(token.c_str() + 1, nullptr, 10);
+                        m_endTime = time;
+                        break;
+
+                    case '0': case '1': case 'x': case 'X': case 'z': case 'Z':
+                        hasValues |= apply(token.c_str() + 1, (token[0] == '1') ? 1 : 0, values);
+                        break;
+
+                    case 'b': case 'B':
+                    {
+                        uint32_t value = 0;
+                        for (size_t i = 1; i < token.size(); ++i)
+                        {
+                            value = (value << 1) | (token[i] == '1');
+                        }
+                        if (!nextToken(token)) return false;
+                        hasValues |= apply(token.c_str(), value, values);
+                        break;
+                    }
+
+                    case 'r': case 'R':
+                        // real values are not mapped, skip the identifier
+                        if (!nextToken(token)) return false;
+                        break;
+
+                    case '$':
+                        if (token == "$comment") skipToEnd();
+                        // $dumpvars, $dumpall, $dumpon, $dumpoff and their $end carry no values
+                        break;
+
+                    default:
+                        std::cerr << "unexpected vcd token " << token << std::endl;
+                        return false;
+                }
+            }
+
+            if (hasValues) report();
+
+            return true;
+        }
+
+        // the last time stamp read
+        uint64_t getEndTime() const { return m_endTime; }
+
+    private:
+        // types
+        struct Mapping
+        {
+            unsigned bit;
+            size_t width;
+        };
+
+        // methods
+        // whitespace separated, a token may span two blocks
+        bool nextToken(std::string &token)
+        {
+            token.clear();
+            while (true)
+            {
+                if (m_position == m_fill)
+                {
+                    m_file.read(m_buffer.data(), m_buffer.size());
+                    m_fill = m_file.gcount();
+                    m_position = 0;
+                    if (m_fill == 0) return !token.empty();
+                }
+
+                if (token.empty())
+                {
+                    while ((m_position < m_fill) && isSpace(m_buffer[m_position])) ++m_position;
+                }
+                size_t start = m_position;
+                while ((m_position < m_fill) && !isSpace(m_buffer[m_position])) ++m_position;
+                token.append(m_buffer.data() + start, m_position - start);
+
+                if ((m_position < m_fill) && !token.empty()) return true;
+            }
+        }
+
+        static bool isSpace(char c)
+        {
+            return std::isspace(static_cast<unsigned char>(c));
+        }
+
+        void skipToEnd()
+        {
+            std::string token;
+            while (nextToken(token) && (token != "$end"))
+            {
+            }
+        }
+
+        bool parseTimescale(const std::string &timescale)
+        {
+            size_t unit = 0;
+            uint64_t number = std::strtoull(timescale.c_str(), nullptr, 10);
+            while ((unit < timescale.size()) && std::isdigit(timescale[unit])) ++unit;
+            auto suffix = timescale.substr(unit);
+
+            if (suffix == "s") m_timescalePs = number * 1000000000000ull;
+            else if (suffix == "ms") m_timescalePs = number * 1000000000ull;
+            else if (suffix == "us") m_timescalePs = number * 1000000ull;
+            else if (suffix == "ns") m_timescalePs = number * 1000ull;
+            else if (suffix == "ps") m_timescalePs = number;
+            else
+            {
+                std::cerr << "unsupported vcd timescale " << timescale << std::endl;
+                return false;
+            }
+
+            return true;
+        }
+
+        // identifiers are short strings of printable characters, read as base 94 numbers
+        static uint64_t encode(const char *identifier)
+        {
+            uint64_t code = 0;
+            for (; *identifier; ++identifier)
+            {
+                code = code * 94 + (*identifier - '!' + 1);
+            }
+            return code;
+        }
+
+        static uint64_t encode(const std::string &identifier)
+        {
+            return encode(identifier.c_str());
+        }
+
+        // returns whether the identifier belongs to a mapped signal
+        bool apply(const char *identifier, uint32_t value, uint32_t &values)
+        {
+            auto mapping = m_mapping.find(encode(identifier));
+            if (mapping == m_mapping.end()) return false;
+
+            for (const auto &target : mapping->second)
+            {
+                uint32_t mask = ((target.width >= 32) ? ~0u : ((1u << target.width) - 1))
+                    << target.bit;
+                values = (values & ~mask) | ((value << target.bit) & mask);
+            }
+
+            return true;
+        }
+
+        // members
+        std::ifstream m_file;
+        std::vector<char> m_buffer;
+        size_t m_fill { 0 };
+        size_t m_position { 0 };
+        std::vector<Variable> m_variables;
+        std::unordered_map<uint64_t, std::vector<Mapping>> m_mapping;
+        uint64_t m_timescalePs { 1000 };
+        uint64_t m_endTime { 0 };
+};
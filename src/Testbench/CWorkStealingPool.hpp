@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdlib>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs a batch of independent jobs on a fixed number of threads. The jobs are dealt out to
+// per-thread queues up front; a thread works its own queue from the front and, once that is
+// empty, steals from the back of the others, so long and short jobs even out across threads.
+class CWorkStealingPool
+{
+    public:
+        // types
+        using Job = std::function<void()>;
+
+        // methods
+        explicit CWorkStealingPool(size_t threads)
+        {
+            if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            for (size_t i = 0; i < threads; ++i)
+            {
+                m_queues.push_back(std::make_unique<Queue>());
+            }
+        }
+
+        size_t getThreadCount() const { return m_queues.size(); }
+
+        // runs all jobs and returns once they are done
+        void run(std::vector<Job> jobs)
+        {
+            for (size_t i = 0; i < jobs.size(); ++i)
+            {
+                m_queues[i % m_queues.size()]->jobs.push_back(std::move(jobs[i]));
+            }
+
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < m_queues.size(); ++i)
+            {
+                threads.emplace_back([this, i]() { work(i); });
+            }
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+    private:
+        // types
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        // methods
+        void work(size_t index)
+        {
+            Job job;
+            while (pop(index, job) || steal(index, job))
+            {
+                job();
+            }
+        }
+
+        bool pop(size_t index, Job &job)
+        {
+            auto &queue = *m_queues[index];
+            std::lock_guard<std::mutex> lock { queue.mutex };
+            if (queue.jobs.empty()) return false;
+
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            return true;
+        }
+
+        bool steal(size_t index, Job &job)
+        {
+            for (size_t n = 1; n < m_queues.size(); ++n)
+            {
+                auto &queue = *m_queues[(index + n) % m_queues.size()];
+                std::lock_guard<std::mutex> lock { queue.mutex };
+                if (queue.jobs.empty()) continue;
+
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                return true;
+            }
+
+            return false;
+        }
+
+        // members
+        std::vector<std::unique_ptr<Queue>> m_queues;
+};
@@ -0,0 +1,155 @@
+#include <algorithm>
+
+#include "CFrameHistory.hpp"
+
+// A run is a control word followed by its data: with the top bit set the control word holds the
+// length of a repeated word that follows, otherwise the number of literal words that follow.
+constexpr uint32_t repeatBit = 0x80000000u;
+
+CFrameHistory::CFrameHistory(size_t maxBytes, size_t keyframeInterval)
+    : m_maxBytes { maxBytes }, m_keyframeInterval { std::max<size_t>(1, keyframeInterval) }
+{
+}
+
+void CFrameHistory::push(size_t index, const uint32_t *pixels, size_t count)
+{
+    // all frames of the history have the same size
+    if (count != m_last.size()) clear();
+
+    Frame frame { index, m_frames.empty() || (m_sinceKeyframe + 1 >= m_keyframeInterval), {} };
+    if (frame.keyframe)
+    {
+        encode(pixels, count, m_encoded);
+        m_sinceKeyframe = 0;
+    }
+    else
+    {
+        m_delta.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_delta[i] = pixels[i] ^ m_last[i];
+        }
+        encode(m_delta.data(), count, m_encoded);
+        ++m_sinceKeyframe;
+    }
+    frame.runs.assign(m_encoded.begin(), m_encoded.end());
+    m_last.assign(pixels, pixels + count);
+
+    m_bytes += frame.runs.size() * sizeof(uint32_t);
+    m_frames.push_back(std::move(frame));
+    while ((m_bytes > m_maxBytes) && (m_frames.size() > 1))
+    {
+        dropOldest();
+    }
+}
+
+void CFrameHistory::clear()
+{
+    m_frames.clear();
+    m_last.clear();
+    m_bytes = 0;
+    m_sinceKeyframe = 0;
+}
+
+bool CFrameHistory::decode(size_t index, std::vector<uint32_t> &pixels) const
+{
+    auto frame = std::lower_bound(m_frames.begin(), m_frames.end(), index,
+            [](const Frame &frame, size_t index) { return frame.index < index; });
+    if ((frame == m_frames.end()) || (frame->index != index)) return false;
+
+    // the oldest frame is always a keyframe
+    auto keyframe = frame;
+    while (!keyframe->keyframe) --keyframe;
+
+    pixels.resize(m_last.size());
+    apply<false>(keyframe->runs, pixels);
+    for (auto delta = keyframe + 1; delta <= frame; ++delta)
+    {
+        apply<true>(delta->runs, pixels);
+    }
+
+    return true;
+}
+
+void CFrameHistory::encode(const uint32_t *words, size_t count, std::vector<uint32_t> &runs)
+{
+    runs.clear();
+
+    size_t literals = 0;
+    auto addLiterals = [&](size_t end)
+        {
+            if (end == literals) return;
+            runs.push_back(static_cast<uint32_t>(end - literals));
+            runs.insert(runs.end(), words + literals, words + end);
+        };
+
+    for (size_t i = 0; i < count;)
+    {
+        size_t end = i + 1;
+        while ((end < count) && (words[end] == words[i])) ++end;
+
+        // shorter repetitions are as cheap as literals
+        if (end - i >= 3)
+        {
+            addLiterals(i);
+            runs.push_back(repeatBit | static_cast<uint32_t>(end - i));
+            runs.push_back(words[i]);
+            literals = end;
+        }
+        i = end;
+    }
+    addLiterals(count);
+}
+
+template <bool applyXor>
+void CFrameHistory::apply(const std::vector<uint32_t> &runs, std::vector<uint32_t> &words)
+{
+    auto word = words.begin();
+    for (size_t i = 0; i < runs.size();)
+    {
+        uint32_t control = runs[i++];
+        size_t length = control & ~repeatBit;
+
+        if (control & repeatBit)
+        {
+            uint32_t value = runs[i++];
+            if (!applyXor) std::fill(word, word + length, value);
+            else if (value != 0)
+            {
+                std::for_each(word, word + length, [=](uint32_t &w) { w ^= value; });
+            }
+        }
+        else if (!applyXor)
+        {
+            std::copy(runs.begin() + i, runs.begin() + i + length, word);
+            i += length;
+        }
+        else
+        {
+            std::transform(runs.begin() + i, runs.begin() + i + length, word, word,
+                    [](uint32_t delta, uint32_t w) { return w ^ delta; });
+            i += length;
+        }
+        word += length;
+    }
+}
+
+void CFrameHistory::dropOldest()
+{
+    // the next frame becomes a keyframe if it is a delta against the dropped one
+    if ((m_frames.size() > 1) && !m_frames[1].keyframe)
+    {
+        std::vector<uint32_t> pixels(m_last.size());
+        apply<false>(m_frames[0].runs, pixels);
+        apply<true>(m_frames[1].runs, pixels);
+        encode(pixels.data(), pixels.size(), m_encoded);
+
+        m_bytes -= m_frames[1].runs.size() * sizeof(uint32_t);
+        m_frames[1].runs.assign(m_encoded.begin(), m_encoded.end());
+        m_frames[1].keyframe = true;
+        m_bytes += m_frames[1].runs.size() * sizeof(uint32_t);
+    }
+
+    m_bytes -= m_frames.front().runs.size() * sizeof(uint32_t);
+    m_frames.pop_front();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// The last completed frames in a memory bounded ring. Each frame is stored as the run length
+// encoded XOR against its predecessor, with a keyframe encoding the frame itself every
+// keyframeInterval frames. Unchanged areas cost a few bytes, so hundreds of frames of a mostly
+// static picture fit in a few MB. The oldest frames are dropped when the budget is exceeded.
+class CFrameHistory
+{
+    public:
+        // methods
+        CFrameHistory(size_t maxBytes, size_t keyframeInterval);
+
+        // adds the frame with the given index, indices must increase
+        void push(size_t index, const uint32_t *pixels, size_t count);
+        void clear();
+
+        size_t size() const { return m_frames.size(); }
+        bool empty() const { return m_frames.empty(); }
+        size_t getOldestIndex() const { return m_frames.empty() ? 0 : m_frames.front().index; }
+        size_t getNewestIndex() const { return m_frames.empty() ? 0 : m_frames.back().index; }
+        size_t getMemoryUsage() const { return m_bytes; }
+
+        // decodes the frame with the given index, false if it is not in the history
+        bool decode(size_t index, std::vector<uint32_t> &pixels) const;
+
+    private:
+        // types
+        struct Frame
+        {
+            size_t index;
+            bool keyframe;
+            std::vector<uint32_t> runs;
+        };
+
+        // methods
+        static void encode(const uint32_t *words, size_t count, std::vector<uint32_t> &runs);
+        template <bool applyXor>
+        static void apply(const std::vector<uint32_t> &runs, std::vector<uint32_t> &words);
+        void dropOldest();
+
+        // members
+        size_t m_maxBytes;
+        size_t m_keyframeInterval;
+        size_t m_bytes { 0 };
+        size_t m_sinceKeyframe { 0 };
+        std::deque<Frame> m_frames;
+        std::vector<uint32_t> m_last;       // the newest frame, the base of the next delta
+        std::vector<uint32_t> m_delta;
+        std::vector<uint32_t> m_encoded;
+};
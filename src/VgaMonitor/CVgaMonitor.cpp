@@ -1,16 +1,66 @@
 #include <iostream>
+#include <algorithm>
+#include <bitset>
 #include <cassert>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <string>
 
+#include "CTraceEvents.hpp"
 #include "CVgaMonitor.hpp"
 #include "imgui/imgui_impl_sdl.h"
 #include "imgui/imgui_impl_sdlrenderer.h"
 
 using namespace std::chrono_literals;
 
+const char *CVgaMonitor::s_phaseNames[7] = {
+    "sync during blanking",
+    "rgb during blanking",
+    "sync during back porch",
+    "rgb during back porch",
+    "sync in active area",
+    "sync during front porch",
+    "rgb during front porch"
+};
+
+const uint8_t CVgaMonitor::s_phaseOfBit[7] = { 0, 0, 1, 1, 2, 3, 3 };
+
+const CVgaMonitor::nanosec CVgaMonitor::s_clockOverhead = CVgaMonitor::measureClockOverhead();
+
+// changes whenever the layout of saveState changes
+constexpr uint32_t monitorStateVersion = 1;
+
+CVgaMonitor::CVgaMonitor(CheckPolicy policy) : m_checkPolicy { policy }
+{
+    switch (policy)
+    {
+        case CheckPolicy::OFF:
+            selectPolicy<CheckPolicy::OFF>();
+            break;
+
+        case CheckPolicy::SYNC_ONLY:
+            selectPolicy<CheckPolicy::SYNC_ONLY>();
+            break;
+
+        case CheckPolicy::FULL:
+            selectPolicy<CheckPolicy::FULL>();
+            break;
+
+        case CheckPolicy::FULL_WITH_STATISTICS:
+            selectPolicy<CheckPolicy::FULL_WITH_STATISTICS>();
+            break;
+
+        default:
+            assert(false);
+            break;
+    }
+}
+
 CVgaMonitor::~CVgaMonitor()
 {
+    if (!m_windowSetup) return;
+
     ImGui_ImplSDLRenderer_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
@@ -22,13 +72,14 @@ CVgaMonitor::~CVgaMonitor()
     SDL_Quit();
 }
 
-bool CVgaMonitor::setup(Mode mode, ColorDepth depth)
+bool CVgaMonitor::setup(Mode mode, ColorDepth depth, Display display)
 {
     auto ok = true;
 
     // Setup simulated monitor buffer and timings
     m_mode = mode;
     m_depth = depth;
+    m_display = display;
 
     switch (mode)
     {
@@ -41,8 +92,28 @@ bool CVgaMonitor::setup(Mode mode, ColorDepth depth)
             break;
     }
     m_numPixels = m_winWidth * m_winHeight;
+    m_pixelsPerLine = m_hPixels.syncPulse + m_hPixels.backPorch + m_hPixels.visibleArea
+        + m_hPixels.frontPorch;
+    updatePhaseRanges();
     m_buffer.resize(m_numPixels, { 0, 0, 0, 0 });
 
+    switch (depth)
+    {
+        case ColorDepth::RGB_3BitPerColor:
+            m_colorBitOffset = 5;
+            break;
+
+        default:
+            assert(false);
+            break;
+    }
+
+    // a headless monitor only fills its frame buffer
+    if (display == Display::HEADLESS)
+    {
+        return ok;
+    }
+    m_windowSetup = true;
 
     // Setup SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0)
@@ -59,24 +130,15 @@ bool CVgaMonitor::setup(Mode mode, ColorDepth depth)
         ok = false;
     }
 
-    m_renderer = rendererPtr { SDL_CreateRenderer(m_window.get(), -1,
-            SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC), SDL_DestroyRenderer };
+    uint32_t rendererFlags = SDL_RENDERER_ACCELERATED | (m_vSync ? SDL_RENDERER_PRESENTVSYNC : 0);
+    m_renderer = rendererPtr { SDL_CreateRenderer(m_window.get(), -1, rendererFlags),
+            SDL_DestroyRenderer };
     if (!m_renderer)
     {
         std::cerr << "vga monitor renderer creation failed: %s\n" << SDL_GetError();
         ok = false;
     }
 
-    switch (depth)
-    {
-        case ColorDepth::RGB_3BitPerColor:
-            m_colorBitOffset = 5;
-            break;
-
-        default:
-            assert(false);
-            break;
-    }
     uint32_t pixelFormat = SDL_PIXELFORMAT_RGB888;
     m_texture = texturePtr { SDL_CreateTexture(m_renderer.get(), pixelFormat,
             SDL_TEXTUREACCESS_STREAMING, m_winWidth, m_winHeight), SDL_DestroyTexture };
@@ -117,65 +179,93 @@ void CVgaMonitor::setupMode_VGA_640x480_60Hz()
     m_vVisibleArea = nanosec { 480 * m_line };
     m_vFrontPorch = nanosec { 10 * m_line };
     m_frame = nanosec { 525 * m_line };
+    m_hPixels = { 96, 48, 640, 16 };
+    m_vLines = { 2, 33, 480, 10 };
     m_winWidth = 640;
     m_winHeight = 480;
 }
 
-void CVgaMonitor::eval(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::selectPolicy()
+{
+    m_evalPolicy = &CVgaMonitor::countedEval<policy>;
+    m_clockPolicy = &CVgaMonitor::countedClock<policy>;
+    m_clockBatchPolicy = &CVgaMonitor::clockBatchWithPolicy<policy>;
+    m_clockRunsPolicy = &CVgaMonitor::clockRunsWithPolicy<policy>;
+    m_changePolicy = &CVgaMonitor::countedChange<policy>;
+}
+
+// the single samples, counted and timed by the instrumented policies only
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::countedEval(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
         std::chrono::nanoseconds elapsed)
 {
-    static TimingInfoBitfield hTimingInfo { 0};
-    static TimingInfoBitfield vTimingInfo { 0};
-    static nanosec th{0};
-    static nanosec tv{0};
-    static bool hSyncLast { false };
-    static bool vSyncLast { false };
+    countSample<policy>([&] { evalWithPolicy<policy>(hSync, vSync, red, green, blue, elapsed); });
+}
 
-    th += elapsed;
-    tv += elapsed;
-    bool isBlack = (red == 0) && (green == 0) && (blue == 0);
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::countedClock(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue)
+{
+    countSample<policy>([&] { clockWithPolicy<policy>(hSync, vSync, red, green, blue); });
+}
 
-    // frame starts on the negative edge of vsync
-    if (vSyncLast && !vSync)
-    {
-        tv = 0ns;
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::countedChange(bool hSync, bool vSync, uint8_t red, uint8_t green,
+        uint8_t blue, std::chrono::nanoseconds hold)
+{
+    countSample<policy>([&] { changeWithPolicy<policy>(hSync, vSync, red, green, blue, hold); });
+}
 
-        // update timing information window
-        if (m_showTimingInfo)
-        {
-            showTimingInfo(hTimingInfo, vTimingInfo);
-        }
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::evalWithPolicy(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+        std::chrono::nanoseconds elapsed)
+{
+    constexpr bool checkTiming = (policy != CheckPolicy::OFF);
+    constexpr bool checkColors =
+        (policy == CheckPolicy::FULL) || (policy == CheckPolicy::FULL_WITH_STATISTICS);
+    constexpr bool collectStatistics = (policy == CheckPolicy::FULL_WITH_STATISTICS);
 
-        // update the displayed texture with the last frame
-        SDL_UpdateTexture(m_texture.get(), NULL, m_buffer.data(), m_winWidth * sizeof(Pixel));
-        SDL_RenderClear(m_renderer.get());
-        SDL_RenderCopy(m_renderer.get(), m_texture.get(), NULL, NULL);
-        ImGui_ImplSDLRenderer_RenderDrawData(ImGui::GetDrawData());
-        SDL_RenderPresent(m_renderer.get());
+    m_th += elapsed;
+    m_tv += elapsed;
 
-        // reset timing info bitfield
-        hTimingInfo = 0;
-        vTimingInfo = 0;
+    // frame starts on the negative edge of vsync
+    if (m_vSyncLast && !vSync)
+    {
+        m_tv = 0ns;
+        startFrame<collectStatistics>();
     }
-    vTimingInfo |= checkSignalTiming(
-        vSync, isBlack, tv, m_vSyncPulse, m_vBackPorch, m_vVisibleArea, m_vFrontPorch, m_tolerance);
-
 
     // line starts on the negative edge of hsync
-    if (hSyncLast && !hSync)
+    if (m_hSyncLast && !hSync)
+    {
+        m_th = 0ns;
+        startLine();
+    }
+
+    if constexpr (checkTiming)
     {
-        th = 0ns;
+        markPhase(Phase::TIMING_CHECK);
+        bool isBlack = checkColors && (red == 0) && (green == 0) && (blue == 0);
+
+        auto vTimingInfo = checkSignalTiming<checkColors>(vSync, isBlack, m_tv, m_vSyncPulse,
+                m_vBackPorch, m_vVisibleArea, m_vFrontPorch, m_tolerance);
+        auto hTimingInfo = checkSignalTiming<checkColors>(hSync, isBlack, m_th, m_hSyncPulse,
+                m_hBackPorch, m_hVisibleArea, m_hFrontPorch, m_tolerance);
+        if (mergeTimingInfo<collectStatistics>(hTimingInfo, vTimingInfo))
+        {
+            reportViolations(hTimingInfo, vTimingInfo,
+                    (m_pixel > 0ns) ? static_cast<size_t>(m_th / m_pixel) : 0);
+        }
+        markPhase(Phase::SAMPLING);
     }
-    hTimingInfo |= checkSignalTiming(
-        hSync, isBlack, th, m_hSyncPulse, m_hBackPorch, m_hVisibleArea, m_hFrontPorch, m_tolerance);
 
     // color the current pixel
     {
         size_t x = m_winWidth;
         size_t y = m_winHeight;
 
-        nanosec xt = th - m_hSyncPulse - m_hBackPorch;
-        nanosec yt = tv - m_vSyncPulse - m_vBackPorch;
+        nanosec xt = m_th - m_hSyncPulse - m_hBackPorch;
+        nanosec yt = m_tv - m_vSyncPulse - m_vBackPorch;
         if ((xt >= 0ns) && (yt >= 0ns) && (m_pixel > 0ns) && (m_line > 0ns))
         {
             x = static_cast<size_t>(xt / m_pixel);
@@ -191,10 +281,448 @@ void CVgaMonitor::eval(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8
         }
     }
 
-    hSyncLast = hSync;
-    vSyncLast = vSync;
+    m_hSyncLast = hSync;
+    m_vSyncLast = vSync;
+}
+
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::clockWithPolicy(bool hSync, bool vSync, uint8_t red, uint8_t green,
+        uint8_t blue)
+{
+    constexpr bool checkTiming = (policy != CheckPolicy::OFF);
+    constexpr bool checkColors =
+        (policy == CheckPolicy::FULL) || (policy == CheckPolicy::FULL_WITH_STATISTICS);
+    constexpr bool collectStatistics = (policy == CheckPolicy::FULL_WITH_STATISTICS);
+
+    ++m_hPixel;
+    ++m_vPixel;
+    if (++m_vLinePixel == m_pixelsPerLine)
+    {
+        m_vLinePixel = 0;
+        ++m_vLine;
+    }
+
+    // frame starts on the negative edge of vsync
+    if (m_vSyncLast && !vSync)
+    {
+        m_vPixel = 0;
+        m_vLine = 0;
+        m_vLinePixel = 0;
+        startFrame<collectStatistics>();
+    }
+
+    // line starts on the negative edge of hsync
+    if (m_hSyncLast && !hSync)
+    {
+        m_hPixel = 0;
+        startLine();
+    }
+
+    if constexpr (checkTiming)
+    {
+        markPhase(Phase::TIMING_CHECK);
+        bool isBlack = checkColors && (red == 0) && (green == 0) && (blue == 0);
+
+        auto vTimingInfo = checkPixelTiming<checkColors>(vSync, isBlack, m_vPixel, m_vRanges);
+        auto hTimingInfo = checkPixelTiming<checkColors>(hSync, isBlack, m_hPixel, m_hRanges);
+        if (mergeTimingInfo<collectStatistics>(hTimingInfo, vTimingInfo))
+        {
+            reportViolations(hTimingInfo, vTimingInfo, m_hPixel);
+        }
+        markPhase(Phase::SAMPLING);
+    }
+
+    // color the current pixel
+    {
+        size_t x = m_hPixel - m_hPixels.syncPulse - m_hPixels.backPorch;
+        size_t y = m_vLine - m_vLines.syncPulse - m_vLines.backPorch;
+
+        // before the active area the subtractions wrap around to large values
+        if ((x < m_winWidth) && (y < m_winHeight))
+        {
+            auto &pixel = m_buffer[y * m_winWidth + x];
+            pixel.r = red << m_colorBitOffset;
+            pixel.g = green << m_colorBitOffset;
+            pixel.b = blue << m_colorBitOffset;
+        }
+    }
+
+    m_hSyncLast = hSync;
+    m_vSyncLast = vSync;
+}
+
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::clockBatchWithPolicy(const uint16_t *samples, size_t count)
+{
+    countBatch<policy>(count, [&]
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto pins = samples[i];
+            clockWithPolicy<policy>(pins & 1, (pins >> 1) & 1, (pins >> 2) & 7, (pins >> 5) & 7,
+                    (pins >> 8) & 7);
+        }
+    });
+}
+
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::runWithPolicy(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+        size_t count)
+{
+    constexpr bool checkTiming = (policy != CheckPolicy::OFF);
+    constexpr bool checkColors =
+        (policy == CheckPolicy::FULL) || (policy == CheckPolicy::FULL_WITH_STATISTICS);
+    constexpr bool collectStatistics = (policy == CheckPolicy::FULL_WITH_STATISTICS);
+
+    if (count == 0) return;
+    m_counters.samples += count;
+
+    // the first pixel of the run, as in clockWithPolicy
+    ++m_hPixel;
+    ++m_vPixel;
+    if (++m_vLinePixel == m_pixelsPerLine)
+    {
+        m_vLinePixel = 0;
+        ++m_vLine;
+    }
+
+    // frame starts on the negative edge of vsync
+    if (m_vSyncLast && !vSync)
+    {
+        m_vPixel = 0;
+        m_vLine = 0;
+        m_vLinePixel = 0;
+        startFrame<collectStatistics>();
+    }
+
+    // line starts on the negative edge of hsync
+    if (m_hSyncLast && !hSync)
+    {
+        m_hPixel = 0;
+        startLine();
+    }
+
+    m_hSyncLast = hSync;
+    m_vSyncLast = vSync;
+
+    if constexpr (checkTiming)
+    {
+        markPhase(Phase::TIMING_CHECK);
+        bool isBlack = checkColors && (red == 0) && (green == 0) && (blue == 0);
+
+        auto vTimingInfo = checkSpanTiming<checkColors>(vSync, isBlack, m_vPixel,
+                m_vPixel + count, m_vRanges);
+        auto hTimingInfo = checkSpanTiming<checkColors>(hSync, isBlack, m_hPixel,
+                m_hPixel + count, m_hRanges);
+        mergeSpanTimingInfo<collectStatistics>(hTimingInfo, vTimingInfo, m_hPixel,
+                m_hPixel + count, m_vPixel, m_vPixel + count, m_hRanges, m_vRanges, 1);
+        markPhase(Phase::SAMPLING);
+    }
+
+    // color the run line by line of the vertical count, without a hsync edge it may wrap
+    {
+        size_t xStart = m_hPixels.syncPulse + m_hPixels.backPorch;
+        size_t yStart = m_vLines.syncPulse + m_vLines.backPorch;
+        size_t h = m_hPixel;
+        size_t line = m_vLine;
+        size_t linePixel = m_vLinePixel;
+        Pixel color { static_cast<uint8_t>(blue << m_colorBitOffset),
+            static_cast<uint8_t>(green << m_colorBitOffset),
+            static_cast<uint8_t>(red << m_colorBitOffset), 0 };
+
+        for (size_t remaining = count; remaining > 0;)
+        {
+            size_t n = std::min(remaining, m_pixelsPerLine - linePixel);
+            size_t y = line - yStart;
+            size_t x0 = std::max(h, xStart);
+            size_t x1 = std::min(h + n, xStart + m_winWidth);
+            if ((y < m_winHeight) && (x0 < x1))
+            {
+                std::fill(m_buffer.begin() + y * m_winWidth + (x0 - xStart),
+                        m_buffer.begin() + y * m_winWidth + (x1 - xStart), color);
+            }
+
+            remaining -= n;
+            h += n;
+            linePixel = 0;
+            ++line;
+        }
+    }
+
+    // the remaining pixels of the run
+    m_hPixel += count - 1;
+    m_vPixel += count - 1;
+    m_vLine += (m_vLinePixel + count - 1) / m_pixelsPerLine;
+    m_vLinePixel = (m_vLinePixel + count - 1) % m_pixelsPerLine;
+}
+
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::clockRunsWithPolicy(const uint32_t *runs, size_t count)
+{
+    // the runs count their samples themselves
+    countBatch<policy>(0, [&]
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto run = runs[i];
+            runWithPolicy<policy>(run & 1, (run >> 1) & 1, (run >> 2) & 7, (run >> 5) & 7,
+                    (run >> 8) & 7, run >> 16);
+        }
+    });
+}
+
+template <CVgaMonitor::CheckPolicy policy>
+void CVgaMonitor::changeWithPolicy(bool hSync, bool vSync, uint8_t red, uint8_t green,
+        uint8_t blue, std::chrono::nanoseconds hold)
+{
+    constexpr bool checkTiming = (policy != CheckPolicy::OFF);
+    constexpr bool checkColors =
+        (policy == CheckPolicy::FULL) || (policy == CheckPolicy::FULL_WITH_STATISTICS);
+    constexpr bool collectStatistics = (policy == CheckPolicy::FULL_WITH_STATISTICS);
+
+    // frame starts on the negative edge of vsync
+    if (m_vSyncLast && !vSync)
+    {
+        m_tv = 0ns;
+        startFrame<collectStatistics>();
+    }
+
+    // line starts on the negative edge of hsync
+    if (m_hSyncLast && !hSync)
+    {
+        m_th = 0ns;
+        startLine();
+    }
+
+    m_hSyncLast = hSync;
+    m_vSyncLast = vSync;
+    if ((hold <= 0ns) || (m_pixel <= 0ns)) return;
+
+    // the span of time the values hold, relative to the last sync edges
+    size_t h0 = m_th.count();
+    size_t h1 = h0 + hold.count();
+    size_t v0 = m_tv.count();
+    size_t v1 = v0 + hold.count();
+
+    if constexpr (checkTiming)
+    {
+        markPhase(Phase::TIMING_CHECK);
+        bool isBlack = checkColors && (red == 0) && (green == 0) && (blue == 0);
+
+        auto vTimingInfo = checkSpanTiming<checkColors>(vSync, isBlack, v0, v1, m_vTimeRanges);
+        auto hTimingInfo = checkSpanTiming<checkColors>(hSync, isBlack, h0, h1, m_hTimeRanges);
+        mergeSpanTimingInfo<collectStatistics>(hTimingInfo, vTimingInfo, h0, h1, v0, v1,
+                m_hTimeRanges, m_vTimeRanges, m_pixel.count());
+        markPhase(Phase::SAMPLING);
+    }
+
+    // color all pixels of the span, a span does not cross the start of a line
+    {
+        size_t hStart = (m_hSyncPulse + m_hBackPorch).count();
+        size_t vStart = (m_vSyncPulse + m_vBackPorch).count();
+        size_t pixel = m_pixel.count();
+        size_t y = (v0 >= vStart) ? (v0 - vStart) / m_line.count() : m_winHeight;
+
+        if ((y < m_winHeight) && (h1 > hStart) && (h0 < hStart + m_winWidth * pixel))
+        {
+            size_t x0 = (h0 > hStart) ? (h0 - hStart) / pixel : 0;
+            size_t x1 = std::min(m_winWidth, (h1 - hStart + pixel - 1) / pixel);
+
+            Pixel color { static_cast<uint8_t>(blue << m_colorBitOffset),
+                static_cast<uint8_t>(green << m_colorBitOffset),
+                static_cast<uint8_t>(red << m_colorBitOffset), 0 };
+            std::fill(m_buffer.begin() + y * m_winWidth + x0,
+                    m_buffer.begin() + y * m_winWidth + x1, color);
+        }
+    }
+
+    m_th += hold;
+    m_tv += hold;
+}
+
+template <bool collectStatistics>
+void CVgaMonitor::startFrame()
+{
+    markPhase(Phase::FRAME);
+    auto start = SteadyClock::now();
+
+    if constexpr (collectStatistics)
+    {
+        ++m_statistics.frames;
+        if ((m_hTimingInfo != 0) || (m_vTimingInfo != 0))
+            ++m_statistics.framesWithViolations;
+    }
+
+    if (m_frameCallback)
+    {
+        m_frameCallback(m_frameCount);
+    }
+
+    if (m_history)
+    {
+        // the pixels are 0x00rrggbb words in the vector's aligned storage
+        const void *pixels = m_buffer.data();
+        auto pushStart = SteadyClock::now();
+        m_history->push(m_frameCount, static_cast<const uint32_t *>(pixels), m_buffer.size());
+        auto pushEnd = SteadyClock::now();
+        m_counters.upload += pushEnd - pushStart;
+        if constexpr (CTraceEvents::enabled) CTraceEvents::record("history", pushStart, pushEnd);
+    }
+
+    if (presentFrame()) ++m_counters.framesDisplayed;
+    else ++m_counters.framesSkipped;
+
+    ++m_counters.frames;
+    m_counters.violations += std::bitset<8> { m_hTimingInfo }.count()
+        + std::bitset<8> { m_vTimingInfo }.count();
+
+    // reset timing info bitfield
+    m_hTimingInfo = 0;
+    m_vTimingInfo = 0;
+
+    ++m_frameCount;
+    m_lineCount = 0;
+
+    auto end = SteadyClock::now();
+    m_frameWork += end - start;
+    if constexpr (CTraceEvents::enabled) CTraceEvents::record("frame", start, end);
+    publishCounters();
+    markPhase(Phase::SAMPLING);
+}
+
+void CVgaMonitor::startLine()
+{
+    // keeps the counters current while there is no vsync
+    if (++m_lineCount % 1024 == 0) publishCounters();
+
+    if ((m_eventPumping == EventPumping::INTERVAL)
+            && (std::chrono::steady_clock::now() >= m_nextEventPump))
+    {
+        pumpEvents();
+    }
+}
+
+// Adds the violations of a sample to those of the frame and leaves only the new ones in the
+// arguments. Returns whether there are new ones to report.
+template <bool collectStatistics>
+bool CVgaMonitor::mergeTimingInfo(TimingInfoBitfield &hTimingInfo,
+        TimingInfoBitfield &vTimingInfo)
+{
+    if constexpr (collectStatistics)
+    {
+        if (vTimingInfo != 0) countViolations(vTimingInfo, m_statistics.vViolations);
+        if (hTimingInfo != 0) countViolations(hTimingInfo, m_statistics.hViolations);
+    }
+
+    hTimingInfo &= ~m_hTimingInfo;
+    vTimingInfo &= ~m_vTimingInfo;
+    m_hTimingInfo |= hTimingInfo;
+    m_vTimingInfo |= vTimingInfo;
+
+    return m_strictMode && ((hTimingInfo | vTimingInfo) != 0);
+}
+
+// mergeTimingInfo for the violations of a span from h0 up to h1 resp. v0 up to v1. Each one
+// is counted with the samples of the span in its phase and reported at the first of them, as
+// if the span had been sampled once per unit.
+template <bool collectStatistics>
+void CVgaMonitor::mergeSpanTimingInfo(TimingInfoBitfield hTimingInfo,
+        TimingInfoBitfield vTimingInfo, size_t h0, size_t h1, size_t v0, size_t v1,
+        const PhaseRanges &hRanges, const PhaseRanges &vRanges, size_t unit)
+{
+    auto merge = [&](bool horizontal, TimingInfoBitfield timingInfo, size_t t0, size_t t1,
+            const PhaseRanges &ranges, std::array<size_t, 7> &counts)
+        {
+            if (timingInfo == 0) return;
+
+            TimingInfoBitfield &frameInfo = horizontal ? m_hTimingInfo : m_vTimingInfo;
+            for (size_t bit = 0; bit < counts.size(); ++bit)
+            {
+                if (!(timingInfo & (1 << bit))) continue;
+
+                size_t first = std::max(t0, ranges.begin[s_phaseOfBit[bit]]);
+                if constexpr (collectStatistics)
+                {
+                    size_t last = std::min(t1, ranges.end[s_phaseOfBit[bit]]);
+                    counts[bit] += std::max<size_t>(1, (last - first) / unit);
+                }
+
+                if (frameInfo & (1 << bit)) continue;
+                frameInfo |= (1 << bit);
+                if (m_strictMode)
+                {
+                    reportViolations(horizontal, 1 << bit, (h0 + first - t0 + unit - 1) / unit);
+                }
+            }
+        };
+
+    merge(false, vTimingInfo, v0, v1, vRanges, m_statistics.vViolations);
+    merge(true, hTimingInfo, h0, h1, hRanges, m_statistics.hViolations);
+}
+
+// Returns whether the frame was shown, a minimized window only pumps the events.
+bool CVgaMonitor::presentFrame()
+{
+    if (m_display == Display::HEADLESS)
+    {
+        return false;
+    }
+
+    auto start = SteadyClock::now();
+    if (m_eventPumping == EventPumping::PER_FRAME)
+    {
+        pumpEvents();
+    }
+    auto uiStart = SteadyClock::now();
+    if constexpr (CTraceEvents::enabled) CTraceEvents::record("events", start, uiStart);
+    if (SDL_GetWindowFlags(m_window.get()) & SDL_WINDOW_MINIMIZED)
+    {
+        m_counters.ui += uiStart - start;
+        return false;
+    }
+
+    // update timing information window
+    if (m_showTimingInfo)
+    {
+        showTimingInfo(m_hTimingInfo, m_vTimingInfo);
+    }
+    auto uploadStart = SteadyClock::now();
+    m_counters.ui += uploadStart - start;
+    if constexpr (CTraceEvents::enabled) CTraceEvents::record("imgui", uiStart, uploadStart);
+
+    // the last frame or the one selected in the history, decoded once
+    const void *pixels = m_buffer.data();
+    if (m_history && !m_historyLive)
+    {
+        if ((m_decodedFrame != m_historyFrame)
+                && m_history->decode(m_historyFrame, m_decodedPixels))
+        {
+            m_decodedFrame = m_historyFrame;
+        }
+        if (m_decodedFrame == m_historyFrame) pixels = m_decodedPixels.data();
+    }
+
+    // update the displayed texture
+    SDL_UpdateTexture(m_texture.get(), NULL, pixels, m_winWidth * sizeof(Pixel));
+    auto presentStart = SteadyClock::now();
+    m_counters.upload += presentStart - uploadStart;
+    if constexpr (CTraceEvents::enabled) CTraceEvents::record("upload", uploadStart, presentStart);
+
+    SDL_RenderClear(m_renderer.get());
+    SDL_RenderCopy(m_renderer.get(), m_texture.get(), NULL, NULL);
+    if (m_showTimingInfo)
+    {
+        ImGui_ImplSDLRenderer_RenderDrawData(ImGui::GetDrawData());
+    }
+    SDL_RenderPresent(m_renderer.get());
+    auto end = SteadyClock::now();
+    m_counters.present += end - presentStart;
+    if constexpr (CTraceEvents::enabled) CTraceEvents::record("present", presentStart, end);
+
+    return true;
 }
 
+template <bool checkColors>
 CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkSignalTiming(
     bool sync, 
     bool isBlack, 
@@ -212,15 +740,17 @@ CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkSignalTiming(
         if (sync) timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_BLANKING));
 
         // colors should be off during blanking
-        if (isBlack) timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_BLANKING));
+        if (checkColors && !isBlack)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_BLANKING));
     }
-    else if ((t * (1.0 + tolerance)) < (syncPulse + backPorch))
+    else if (((t * (1.0 - tolerance)) > syncPulse)
+            && ((t * (1.0 + tolerance)) < (syncPulse + backPorch)))
     {
         // vsync should be high during back porch
         if (!sync) timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_BACK_PORCH));
 
         // colors should be off during back porch
-        if (isBlack)
+        if (checkColors && !isBlack)
             timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_BACK_PORCH));
     }
     else if (((t * (1.0 - tolerance)) > (syncPulse + backPorch))
@@ -238,15 +768,397 @@ CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkSignalTiming(
             timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_FRONT_PORCH));
 
         // colors should be off during front porch
-        if (isBlack) timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_FRONT_PORCH));
+        if (checkColors && !isBlack)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_FRONT_PORCH));
     }
 
     return timingInfo;
 }
 
-bool CVgaMonitor::hasQuitEvent()
+template CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkSignalTiming<false>(
+    bool, bool, nanosec, nanosec, nanosec, nanosec, nanosec, double);
+template CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkSignalTiming<true>(
+    bool, bool, nanosec, nanosec, nanosec, nanosec, nanosec, double);
+
+template <bool checkColors>
+CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkPixelTiming(
+    bool sync,
+    bool isBlack,
+    size_t t,
+    const PhaseRanges &ranges)
 {
-    auto shallQuit = false;
+    TimingInfoBitfield timingInfo { 0 };
+    if (t < ranges.end[0])
+    {
+        // sync should be low during blanking
+        if (sync) timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_BLANKING));
+
+        // colors should be off during blanking
+        if (checkColors && !isBlack)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_BLANKING));
+    }
+    else if ((t >= ranges.begin[1]) && (t < ranges.end[1]))
+    {
+        // sync should be high during back porch
+        if (!sync) timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_BACK_PORCH));
+
+        // colors should be off during back porch
+        if (checkColors && !isBlack)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_BACK_PORCH));
+    }
+    else if ((t >= ranges.begin[2]) && (t < ranges.end[2]))
+    {
+        // sync should be high in active area
+        if (!sync)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_ACTIVE_AREA));
+    }
+    else if ((t >= ranges.begin[3]) && (t < ranges.end[3]))
+    {
+        // sync should be high during front porch
+        if (!sync)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_FRONT_PORCH));
+
+        // colors should be off during front porch
+        if (checkColors && !isBlack)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_FRONT_PORCH));
+    }
+
+    return timingInfo;
+}
+
+template CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkPixelTiming<false>(
+    bool, bool, size_t, const PhaseRanges &);
+template CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkPixelTiming<true>(
+    bool, bool, size_t, const PhaseRanges &);
+
+template <bool checkColors>
+CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkSpanTiming(
+    bool sync,
+    bool isBlack,
+    size_t t0,
+    size_t t1,
+    const PhaseRanges &ranges)
+{
+    // the phases the span overlaps
+    auto overlaps = [&](size_t phase)
+        {
+            return (t0 < ranges.end[phase]) && (t1 > ranges.begin[phase]);
+        };
+
+    TimingInfoBitfield timingInfo { 0 };
+    if (overlaps(0))
+    {
+        // sync should be low during blanking
+        if (sync) timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_BLANKING));
+
+        // colors should be off during blanking
+        if (checkColors && !isBlack)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_BLANKING));
+    }
+    if (overlaps(1))
+    {
+        // sync should be high during back porch
+        if (!sync) timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_BACK_PORCH));
+
+        // colors should be off during back porch
+        if (checkColors && !isBlack)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_BACK_PORCH));
+    }
+    if (overlaps(2))
+    {
+        // sync should be high in active area
+        if (!sync)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_ACTIVE_AREA));
+    }
+    if (overlaps(3))
+    {
+        // sync should be high during front porch
+        if (!sync)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::SYNC_FRONT_PORCH));
+
+        // colors should be off during front porch
+        if (checkColors && !isBlack)
+            timingInfo |= (1 << static_cast<uint8_t>(TimingInfoBits::RGB_FRONT_PORCH));
+    }
+
+    return timingInfo;
+}
+
+template CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkSpanTiming<false>(
+    bool, bool, size_t, size_t, const PhaseRanges &);
+template CVgaMonitor::TimingInfoBitfield CVgaMonitor::checkSpanTiming<true>(
+    bool, bool, size_t, size_t, const PhaseRanges &);
+
+// The ranges hold the same samples that checkSignalTiming checks: a phase from start to end
+// covers the counts t with t * (1 - tolerance) > start and t * (1 + tolerance) < end.
+CVgaMonitor::PhaseRanges CVgaMonitor::getPhaseRanges(size_t syncPulse, size_t backPorch,
+        size_t visibleArea, size_t frontPorch, double tolerance)
+{
+    // first count above start, resp. first count not below end
+    auto firstAbove = [&](size_t start)
+        {
+            auto t = static_cast<size_t>(std::floor(start / (1.0 - tolerance)));
+            while ((t * (1.0 - tolerance)) <= start) ++t;
+            while ((t > 0) && ((t - 1) * (1.0 - tolerance) > start)) --t;
+            return t;
+        };
+    auto firstNotBelow = [&](size_t end)
+        {
+            auto t = static_cast<size_t>(std::ceil(end / (1.0 + tolerance)));
+            while ((t * (1.0 + tolerance)) < end) ++t;
+            while ((t > 0) && ((t - 1) * (1.0 + tolerance) >= end)) --t;
+            return t;
+        };
+
+    const size_t bounds[5] = {
+        0, syncPulse, syncPulse + backPorch, syncPulse + backPorch + visibleArea,
+        syncPulse + backPorch + visibleArea + frontPorch
+    };
+
+    PhaseRanges ranges;
+    for (size_t phase = 0; phase < ranges.begin.size(); ++phase)
+    {
+        // a count in two phases belongs to the first, as in checkPixelTiming
+        ranges.begin[phase] =
+            (phase == 0) ? 0 : std::max(firstAbove(bounds[phase]), ranges.end[phase - 1]);
+        ranges.end[phase] = firstNotBelow(bounds[phase + 1]);
+    }
+
+    return ranges;
+}
+
+void CVgaMonitor::updatePhaseRanges()
+{
+    m_hRanges = getPhaseRanges(m_hPixels.syncPulse, m_hPixels.backPorch, m_hPixels.visibleArea,
+            m_hPixels.frontPorch, m_tolerance);
+    m_vRanges = getPhaseRanges(m_vLines.syncPulse * m_pixelsPerLine,
+            m_vLines.backPorch * m_pixelsPerLine, m_vLines.visibleArea * m_pixelsPerLine,
+            m_vLines.frontPorch * m_pixelsPerLine, m_tolerance);
+
+    // the same in nanoseconds, for edge-driven sampling
+    m_hTimeRanges = getPhaseRanges(m_hSyncPulse.count(), m_hBackPorch.count(),
+            m_hVisibleArea.count(), m_hFrontPorch.count(), m_tolerance);
+    m_vTimeRanges = getPhaseRanges(m_vSyncPulse.count(), m_vBackPorch.count(),
+            m_vVisibleArea.count(), m_vFrontPorch.count(), m_tolerance);
+}
+
+void CVgaMonitor::countViolations(TimingInfoBitfield timingInfo, std::array<size_t, 7> &counts)
+{
+    for (size_t bit = 0; bit < counts.size(); ++bit)
+    {
+        if (timingInfo & (1 << bit)) ++counts[bit];
+    }
+}
+
+void CVgaMonitor::copyFrame(std::vector<uint32_t> &frame) const
+{
+    frame.resize(m_buffer.size());
+    for (size_t i = 0; i < m_buffer.size(); ++i)
+    {
+        const auto &pixel = m_buffer[i];
+        frame[i] = (static_cast<uint32_t>(pixel.r) << 16) | (static_cast<uint32_t>(pixel.g) << 8)
+            | pixel.b;
+    }
+}
+
+uint64_t CVgaMonitor::hashFrame() const
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const auto &pixel : m_buffer)
+    {
+        for (auto color : { pixel.r, pixel.g, pixel.b })
+        {
+            hash ^= color;
+            hash *= 0x100000001b3;
+        }
+    }
+
+    return hash;
+}
+
+void CVgaMonitor::setFrameCallback(FrameCallback callback)
+{
+    m_frameCallback = std::move(callback);
+}
+
+void CVgaMonitor::setFrameHistory(size_t maxBytes, size_t keyframeInterval)
+{
+    m_history.reset((maxBytes > 0) ? new CFrameHistory { maxBytes, keyframeInterval } : nullptr);
+    m_historyLive = true;
+    m_decodedFrame = SIZE_MAX;
+}
+
+// the mean like the timed samples see it, the least read would leave most of it in
+CVgaMonitor::nanosec CVgaMonitor::measureClockOverhead()
+{
+    constexpr int tries = 1000;
+    nanosec total { 0 };
+    for (int i = 0; i < tries; ++i)
+    {
+        auto start = SteadyClock::now();
+        total += SteadyClock::now() - start;
+    }
+    return total / tries;
+}
+
+CVgaMonitor::PerformanceCounters CVgaMonitor::getPerformanceCounters() const
+{
+    std::lock_guard<std::mutex> lock { m_countersMutex };
+    return m_publishedCounters;
+}
+
+void CVgaMonitor::publishCounters()
+{
+    std::lock_guard<std::mutex> lock { m_countersMutex };
+    m_publishedCounters = m_counters;
+}
+
+void CVgaMonitor::setPhaseMarker(std::atomic<uint8_t> &marker, uint8_t base)
+{
+    m_phaseMarker = &marker;
+    m_phaseBase = base;
+}
+
+void CVgaMonitor::saveState(std::vector<uint8_t> &state) const
+{
+    auto put = [&](const auto &value)
+        {
+            auto bytes = reinterpret_cast<const uint8_t *>(&value);
+            state.insert(state.end(), bytes, bytes + sizeof(value));
+        };
+
+    // the phase of the first violation as an index into s_phaseNames
+    uint8_t firstPhase = 0;
+    while ((firstPhase < 7) && (m_firstViolation.phase != s_phaseNames[firstPhase])) ++firstPhase;
+
+    state.clear();
+    put(monitorStateVersion);
+    put(m_mode);
+    put(m_depth);
+    put(m_buffer.size());
+    put(m_th);
+    put(m_tv);
+    put(m_hSyncLast);
+    put(m_vSyncLast);
+    put(m_hPixel);
+    put(m_vPixel);
+    put(m_vLine);
+    put(m_vLinePixel);
+    put(m_hTimingInfo);
+    put(m_vTimingInfo);
+    put(m_statistics);
+    put(m_frameCount);
+    put(m_lineCount);
+    put(m_violationCount);
+    put(m_timingFailure);
+    put(m_firstViolation.horizontal);
+    put(firstPhase);
+    put(m_firstViolation.frame);
+    put(m_firstViolation.line);
+    put(m_firstViolation.pixel);
+
+    auto pixels = reinterpret_cast<const uint8_t *>(m_buffer.data());
+    state.insert(state.end(), pixels, pixels + m_buffer.size() * sizeof(Pixel));
+}
+
+bool CVgaMonitor::restoreState(const std::vector<uint8_t> &state)
+{
+    // a state saved by this monitor has the same size
+    std::vector<uint8_t> current;
+    saveState(current);
+
+    size_t offset = 0;
+    auto get = [&](auto &value)
+        {
+            if (offset + sizeof(value) > state.size()) return false;
+            std::memcpy(&value, state.data() + offset, sizeof(value));
+            offset += sizeof(value);
+            return true;
+        };
+
+    uint32_t version = 0;
+    Mode mode;
+    ColorDepth depth;
+    size_t pixels = 0;
+    if (!get(version) || (version != monitorStateVersion) || !get(mode) || (mode != m_mode)
+            || !get(depth) || (depth != m_depth) || !get(pixels) || (pixels != m_buffer.size())
+            || (state.size() != current.size()))
+    {
+        std::cerr << "vga monitor state does not match the monitor" << std::endl;
+        return false;
+    }
+
+    uint8_t firstPhase = 0;
+    get(m_th);
+    get(m_tv);
+    get(m_hSyncLast);
+    get(m_vSyncLast);
+    get(m_hPixel);
+    get(m_vPixel);
+    get(m_vLine);
+    get(m_vLinePixel);
+    get(m_hTimingInfo);
+    get(m_vTimingInfo);
+    get(m_statistics);
+    get(m_frameCount);
+    get(m_lineCount);
+    get(m_violationCount);
+    get(m_timingFailure);
+    get(m_firstViolation.horizontal);
+    get(firstPhase);
+    get(m_firstViolation.frame);
+    get(m_firstViolation.line);
+    get(m_firstViolation.pixel);
+    m_firstViolation.phase = (firstPhase < 7) ? s_phaseNames[firstPhase] : "";
+
+    std::memcpy(m_buffer.data(), state.data() + offset, m_buffer.size() * sizeof(Pixel));
+
+    return true;
+}
+
+void CVgaMonitor::reportViolations(TimingInfoBitfield hTimingInfo, TimingInfoBitfield vTimingInfo,
+        size_t pixel)
+{
+    if (vTimingInfo != 0) reportViolations(false, vTimingInfo, pixel);
+    if (hTimingInfo != 0) reportViolations(true, hTimingInfo, pixel);
+}
+
+void CVgaMonitor::reportViolations(bool horizontal, TimingInfoBitfield timingInfo, size_t pixel)
+{
+    if (m_frameCount < m_warmupFrames) return;
+
+    for (size_t bit = 0; bit < m_statistics.hViolations.size(); ++bit)
+    {
+        if (!(timingInfo & (1 << bit))) continue;
+
+        TimingViolation violation;
+        violation.horizontal = horizontal;
+        violation.phase = s_phaseNames[bit];
+        violation.frame = m_frameCount;
+        violation.line = m_lineCount;
+        violation.pixel = pixel;
+
+        if (m_violationCount == 0) m_firstViolation = violation;
+        ++m_violationCount;
+        if (m_violationCount >= m_maxViolations) m_timingFailure = true;
+
+        if (m_violationCallback) m_violationCallback(violation);
+    }
+}
+
+std::string CVgaMonitor::toString(const TimingViolation &violation)
+{
+    return std::string { "timing violation: " } + (violation.horizontal ? "horizontal " : "vertical ")
+        + violation.phase + " at frame " + std::to_string(violation.frame) + ", line "
+        + std::to_string(violation.line) + ", pixel " + std::to_string(violation.pixel);
+}
+
+void CVgaMonitor::pumpEvents()
+{
+    if (m_display == Display::HEADLESS)
+    {
+        return;
+    }
 
     SDL_Event e;
     while (SDL_PollEvent(&e))
@@ -254,29 +1166,131 @@ bool CVgaMonitor::hasQuitEvent()
         ImGui_ImplSDL2_ProcessEvent(&e);
         if (e.type == SDL_QUIT)
         {
-            shallQuit = true;
+            m_quitRequested.store(true, std::memory_order_relaxed);
+        }
+        else if ((e.type == SDL_KEYDOWN) && !e.key.repeat
+                && ((e.key.keysym.sym == SDLK_p) || (e.key.keysym.sym == SDLK_SPACE)))
+        {
+            // toggle pause
+            m_pauseRequested.store(!isPaused(), std::memory_order_relaxed);
         }
     }
 
-    return shallQuit;
+    m_nextEventPump = std::chrono::steady_clock::now() + m_eventInterval;
+}
+
+void CVgaMonitor::setEventPumping(EventPumping pumping, std::chrono::milliseconds interval)
+{
+    m_eventPumping = pumping;
+    m_eventInterval = interval;
 }
 
 void CVgaMonitor::setShowTimingInfo(bool showTimingInfo)
 {
     m_showTimingInfo = showTimingInfo;
-} void CVgaMonitor::setTimingTolerance(double tolerance)
+}
+
+void CVgaMonitor::setTimingTolerance(double tolerance)
 {
     m_tolerance = tolerance;
+    updatePhaseRanges();
+}
+
+void CVgaMonitor::setVSync(bool vSync)
+{
+    m_vSync = vSync;
+}
+
+void CVgaMonitor::setStrictMode(size_t maxViolations, size_t warmupFrames,
+        ViolationCallback callback)
+{
+    m_strictMode = true;
+    m_maxViolations = std::max<size_t>(maxViolations, 1);
+    m_warmupFrames = warmupFrames;
+    m_violationCallback = std::move(callback);
 }
 
 void CVgaMonitor::showTimingInfo(TimingInfoBitfield hTimingInfo, TimingInfoBitfield vTimingInfo)
 {
-    // TODO: use some nice imgui widgets to show the signal timing information
     ImGui_ImplSDLRenderer_NewFrame();
     ImGui_ImplSDL2_NewFrame(m_window.get());
     ImGui::NewFrame();
 
-    ImGui::ShowDemoWindow();
+    ImGui::Begin("Signal Timing");
+    if (m_checkPolicy == CheckPolicy::OFF)
+    {
+        ImGui::Text("timing checks disabled");
+    }
+    else
+    {
+        // violations of the last frame and, if collected, the number of violating samples
+        for (size_t bit = 0; bit < m_statistics.hViolations.size(); ++bit)
+        {
+            bool h = hTimingInfo & (1 << bit);
+            bool v = vTimingInfo & (1 << bit);
+            if (m_checkPolicy == CheckPolicy::FULL_WITH_STATISTICS)
+            {
+                ImGui::Text("%-24s h: %s (%zu)  v: %s (%zu)", s_phaseNames[bit], h ? "X" : "-",
+                        m_statistics.hViolations[bit], v ? "X" : "-",
+                        m_statistics.vViolations[bit]);
+            }
+            else
+            {
+                ImGui::Text("%-24s h: %s  v: %s", s_phaseNames[bit], h ? "X" : "-", v ? "X" : "-");
+            }
+        }
+
+        if (m_checkPolicy == CheckPolicy::FULL_WITH_STATISTICS)
+        {
+            ImGui::Separator();
+            ImGui::Text("frames with violations: %zu / %zu", m_statistics.framesWithViolations,
+                    m_statistics.frames);
+        }
+    }
+
+    // where the time goes, as of the last frame start
+    {
+        const auto &counters = m_counters;
+        auto perFrame = [&](std::chrono::nanoseconds t)
+            {
+                return t.count() / 1.0e6 / std::max<size_t>(1, counters.frames);
+            };
+
+        ImGui::Separator();
+        ImGui::Text("samples: %zu  frames: %zu shown, %zu skipped  violations: %zu",
+                counters.samples, counters.framesDisplayed, counters.framesSkipped,
+                counters.violations);
+        ImGui::Text("ms per frame: sampling %.2f  upload %.2f  present %.2f  ui %.2f",
+                perFrame(counters.sampling), perFrame(counters.upload),
+                perFrame(counters.present), perFrame(counters.ui));
+    }
+    ImGui::End();
+
+    if (m_history) showFrameHistory();
 
     ImGui::Render();
-}
\ No newline at end of file
+}
+
+void CVgaMonitor::showFrameHistory()
+{
+    ImGui::Begin("Frame History");
+    if (m_history->empty())
+    {
+        ImGui::Text("no frames yet");
+    }
+    else
+    {
+        // moving the slider leaves the live view, the selected frame stays while new ones come
+        int oldest = static_cast<int>(m_history->getOldestIndex());
+        int newest = static_cast<int>(m_history->getNewestIndex());
+        int frame = m_historyLive ? newest
+            : std::max(oldest, std::min(newest, static_cast<int>(m_historyFrame)));
+        if (ImGui::SliderInt("frame", &frame, oldest, newest)) m_historyLive = false;
+        ImGui::Checkbox("live", &m_historyLive);
+        m_historyFrame = frame;
+
+        ImGui::Text("%zu frames in %.1f MB", m_history->size(),
+                m_history->getMemoryUsage() / 1.0e6);
+    }
+    ImGui::End();
+}
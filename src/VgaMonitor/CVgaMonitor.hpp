@@ -2,12 +2,19 @@
 
 #include <cstdlib>
 #include <cstdint>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include <SDL.h>
 
+#include "CFrameHistory.hpp"
+
 class CVgaMonitor
 {
     public:
@@ -22,11 +29,107 @@ class CVgaMonitor
             RGB_3BitPerColor
         };
 
+        // HEADLESS decodes frames into the frame buffer without touching SDL
+        enum class Display
+        {
+            WINDOW, HEADLESS
+        };
+
+        // Signal timing validation performed on every sample. The policy is fixed at
+        // construction and each one is a separate instantiation of the sampling loop, so
+        // OFF does not pay for any of the checks.
+        enum class CheckPolicy
+        {
+            OFF,                    // capture pixels only
+            SYNC_ONLY,              // check the sync levels of each timing phase
+            FULL,                   // additionally check that colors are off during blanking
+            FULL_WITH_STATISTICS    // additionally count the violating samples per phase
+        };
+
+        // violations of one timing phase, as bit positions in a TimingInfoBitfield
+        enum class TimingInfoBits : uint8_t
+        {
+            SYNC_BLANKING = 0,
+            RGB_BLANKING = 1,
+            SYNC_BACK_PORCH = 2,
+            RGB_BACK_PORCH = 3,
+            SYNC_ACTIVE_AREA = 4,
+            SYNC_FRONT_PORCH = 5,
+            RGB_FRONT_PORCH = 6
+        };
+        using TimingInfoBitfield = uint8_t;
+
+        // number of samples that violated the timing of each phase, indexed by TimingInfoBits
+        struct TimingStatistics
+        {
+            size_t frames { 0 };
+            size_t framesWithViolations { 0 };
+            std::array<size_t, 7> hViolations {};
+            std::array<size_t, 7> vViolations {};
+        };
+
+        // A timing violation as reported in strict mode. Lines and pixels are counted from the
+        // falling edge of the respective sync pulse, frame 0 is the frame before the first vsync.
+        struct TimingViolation
+        {
+            bool horizontal { false };
+            const char *phase { "" };
+            size_t frame { 0 };
+            size_t line { 0 };
+            size_t pixel { 0 };
+        };
+        using ViolationCallback = std::function<void(const TimingViolation &)>;
+
+        // called with the index of every completed frame while the frame buffer still holds it
+        using FrameCallback = std::function<void(size_t frame)>;
+
+        // The samples, counted from the falling edge of a sync pulse, in which the blanking,
+        // back porch, active area and front porch are checked. Samples near the phase
+        // boundaries are left out by the timing tolerance.
+        struct PhaseRanges
+        {
+            std::array<size_t, 4> begin {};
+            std::array<size_t, 4> end {};
+        };
+
+        // When the monitor polls the SDL event queue. INTERVAL checks the wall clock once per
+        // line, MANUAL leaves it to the thread owning the window to call pumpEvents().
+        enum class EventPumping
+        {
+            PER_FRAME, INTERVAL, MANUAL
+        };
+
+        // Cheap counters of the work done, kept without synchronization on the sampling thread
+        // and published at every frame start. Batches are timed as a whole. Single samples are
+        // timed one in sampleTimingInterval, less the cost of reading the clock, and
+        // extrapolated, so their sampling time is an estimate. Neither includes the frame work
+        // of the frame starts in them. Only the policies that check the colors read the clock,
+        // OFF and SYNC_ONLY count their samples but leave the sampling time at zero.
+        struct PerformanceCounters
+        {
+            size_t samples { 0 };           // a run counts with its length, a change as one
+            size_t frames { 0 };
+            size_t framesDisplayed { 0 };
+            size_t framesSkipped { 0 };     // headless or while the window is minimized
+            size_t violations { 0 };        // violated phases per frame and axis
+            std::chrono::nanoseconds sampling { 0 };
+            std::chrono::nanoseconds upload { 0 };      // frame history and texture update
+            std::chrono::nanoseconds present { 0 };     // rendering, including the vsync wait
+            std::chrono::nanoseconds ui { 0 };          // event pumping and the ImGui windows
+        };
+        static constexpr size_t sampleTimingInterval = 256;
+
+        // The phases the monitor marks for a sampling profiler of the calling thread
+        enum class Phase : uint8_t
+        {
+            SAMPLING, TIMING_CHECK, FRAME
+        };
+
         // methods
-        CVgaMonitor() = default;
+        explicit CVgaMonitor(CheckPolicy policy = CheckPolicy::FULL);
         ~CVgaMonitor();
 
-        bool setup(Mode mode, ColorDepth depth);
+        bool setup(Mode mode, ColorDepth depth, Display display = Display::WINDOW);
         bool setup()
         {
             return setup(Mode::VGA_640x480_60Hz, ColorDepth::RGB_3BitPerColor);
@@ -35,10 +138,123 @@ class CVgaMonitor
         void setShowTimingInfo(bool showTimingInfo);
         void setTimingTolerance(double tolerance);
 
+        // whether presenting a frame waits for the display's vsync, has to be set before setup
+        void setVSync(bool vSync);
+
+        // Strict mode: every new violation after the warm-up frames is passed to the callback
+        // and after maxViolations of them hasTimingFailure() turns true. A violation is new if
+        // its phase has not been violated on the same axis earlier in the frame.
+        void setStrictMode(size_t maxViolations, size_t warmupFrames,
+                ViolationCallback callback = nullptr);
+        bool hasTimingFailure() const { return m_timingFailure; }
+        size_t getViolationCount() const { return m_violationCount; }
+        const TimingViolation &getFirstViolation() const { return m_firstViolation; }
+        static std::string toString(const TimingViolation &violation);
+
+        // one sample after the given time, for video clocks that differ from the sim clock
         void eval(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
-                std::chrono::nanoseconds elapsed);
+                std::chrono::nanoseconds elapsed)
+        {
+            (this->*m_evalPolicy)(hSync, vSync, red, green, blue, elapsed);
+        }
+
+        // One sample per pixel clock, e.g. on every rising edge of a design clocked by the pixel
+        // clock. Timing is counted in pixels, so there is one call per pixel and no time
+        // arithmetic. Don't mix it with eval() on the same monitor.
+        void clockPixel(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue)
+        {
+            (this->*m_clockPolicy)(hSync, vSync, red, green, blue);
+        }
+
+        // Edge-driven sampling: the inputs changed to the given values and hold them for the
+        // given time. One call per change covers all pixels in between, which suits sources of
+        // value changes like waveform dumps.
+        void evalChange(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+                std::chrono::nanoseconds hold)
+        {
+            (this->*m_changePolicy)(hSync, vSync, red, green, blue, hold);
+        }
 
-        bool hasQuitEvent();
+        // clockPixel for a batch of packed samples: hsync in bit 0, vsync in bit 1, then three
+        // bits each of red, green and blue
+        void clockPixels(const uint16_t *samples, size_t count)
+        {
+            (this->*m_clockBatchPolicy)(samples, count);
+        }
+
+        // clockPixel for a batch of runs of equal samples: the pins packed as for clockPixels in
+        // the low 16 bits, the number of pixel clocks they hold in the high 16 bits. Each run is
+        // checked and drawn as a whole, with the same results as its samples.
+        void clockRuns(const uint32_t *runs, size_t count)
+        {
+            (this->*m_clockRunsPolicy)(runs, count);
+        }
+
+        void setEventPumping(EventPumping pumping,
+                std::chrono::milliseconds interval = std::chrono::milliseconds { 20 });
+        void pumpEvents();
+
+        // cheap to call every sample, updated whenever events are pumped
+        bool hasQuitEvent() const { return m_quitRequested.load(std::memory_order_relaxed); }
+        bool isPaused() const { return m_pauseRequested.load(std::memory_order_relaxed); }
+
+        CheckPolicy getCheckPolicy() const { return m_checkPolicy; }
+        const TimingStatistics &getTimingStatistics() const { return m_statistics; }
+        void resetTimingStatistics() { m_statistics = TimingStatistics {}; }
+        size_t getFrameCount() const { return m_frameCount; }
+
+        // the counters as of the last frame start, safe to call from any thread
+        PerformanceCounters getPerformanceCounters() const;
+
+        // Marks each Phase in the given byte, as base plus the phase, with a relaxed store on
+        // every transition. The caller marks its own phases in between monitor calls.
+        void setPhaseMarker(std::atomic<uint8_t> &marker, uint8_t base);
+
+        size_t getWidth() const { return m_winWidth; }
+        size_t getHeight() const { return m_winHeight; }
+
+        // The frame buffer as 0x00RRGGBB pixels, row by row. It holds the last complete frame
+        // only right after a frame start, later samples already overwrite it.
+        void copyFrame(std::vector<uint32_t> &frame) const;
+
+        // FNV-1a hash of the frame buffer colors, same validity as copyFrame
+        uint64_t hashFrame() const;
+
+        void setFrameCallback(FrameCallback callback);
+
+        // Keeps the completed frames in a history of at most maxBytes, 0 turns it off. The
+        // timing info window then scrubs back through it while the simulation keeps running.
+        void setFrameHistory(size_t maxBytes, size_t keyframeInterval = 30);
+        const CFrameHistory *getFrameHistory() const { return m_history.get(); }
+
+        // redraws the window with the events pumped as on a frame start, e.g. while paused
+        void refreshDisplay() { presentFrame(); }
+
+        // The sampling state, frame buffer, statistics and violation counts, for checkpoints of
+        // a simulation. The state is restored into a monitor set up with the same mode; settings
+        // and callbacks are not part of it.
+        void saveState(std::vector<uint8_t> &state) const;
+        bool restoreState(const std::vector<uint8_t> &state);
+
+        // timing phase violations of a single sample, instantiated with and without checking
+        // that the colors are off during blanking
+        template <bool checkColors>
+        static TimingInfoBitfield checkSignalTiming(
+            bool sync, bool isBlack, std::chrono::nanoseconds t,
+            std::chrono::nanoseconds syncPulse, std::chrono::nanoseconds backPorch,
+            std::chrono::nanoseconds visibleArea, std::chrono::nanoseconds frontPorch,
+            double tolerance);
+
+        // the same check for a sample counted in pixels
+        template <bool checkColors>
+        static TimingInfoBitfield checkPixelTiming(
+            bool sync, bool isBlack, size_t t, const PhaseRanges &ranges);
+        // the same check for a span of samples from t0 up to t1, counted in pixels or ns
+        template <bool checkColors>
+        static TimingInfoBitfield checkSpanTiming(
+            bool sync, bool isBlack, size_t t0, size_t t1, const PhaseRanges &ranges);
+        static PhaseRanges getPhaseRanges(size_t syncPulse, size_t backPorch, size_t visibleArea,
+                size_t frontPorch, double tolerance);
 
     private:
         // types
@@ -57,28 +273,122 @@ class CVgaMonitor
                 uint8_t padding;
         } __attribute__((__packed__));
 
-        enum class TimingInfoBits : uint8_t
+        // length of the timing phases of one axis, in pixels or lines
+        struct AxisTiming
         {
-            SYNC_BLANKING = 0,
-            RGB_BLANKING = 1,
-            SYNC_BACK_PORCH = 2,
-            RGB_BACK_PORCH = 3,
-            SYNC_ACTIVE_AREA = 4,
-            SYNC_FRONT_PORCH = 5,
-            RGB_FRONT_PORCH = 6
+            size_t syncPulse { 0 };
+            size_t backPorch { 0 };
+            size_t visibleArea { 0 };
+            size_t frontPorch { 0 };
         };
-        using TimingInfoBitfield = uint8_t;
+
+        using EvalFunc = void (CVgaMonitor::*)(
+            bool, bool, uint8_t, uint8_t, uint8_t, std::chrono::nanoseconds);
+        using ClockFunc = void (CVgaMonitor::*)(bool, bool, uint8_t, uint8_t, uint8_t);
+        using ClockBatchFunc = void (CVgaMonitor::*)(const uint16_t *, size_t);
+        using ClockRunsFunc = void (CVgaMonitor::*)(const uint32_t *, size_t);
+
+        using SteadyClock = std::chrono::steady_clock;
 
         // methods
+        void markPhase(Phase phase)
+        {
+            m_phaseMarker->store(m_phaseBase + static_cast<uint8_t>(phase),
+                    std::memory_order_relaxed);
+        }
+
+        // whether a policy reads the clock to time its samples, all of them count the samples
+        // and mark the phases
+        static constexpr bool isInstrumented(CheckPolicy policy)
+        {
+            return (policy == CheckPolicy::FULL) || (policy == CheckPolicy::FULL_WITH_STATISTICS);
+        }
+        template <CheckPolicy policy, typename Sample>
+        void countSample(Sample &&sample)
+        {
+            markPhase(Phase::SAMPLING);
+            ++m_counters.samples;
+            if constexpr (isInstrumented(policy))
+            {
+                if (m_counters.samples % sampleTimingInterval != 0) sample();
+                else timeSampling(sample, sampleTimingInterval, s_clockOverhead);
+            }
+            else sample();
+        }
+        template <CheckPolicy policy, typename Batch>
+        void countBatch(size_t count, Batch &&batch)
+        {
+            markPhase(Phase::SAMPLING);
+            m_counters.samples += count;
+            if constexpr (isInstrumented(policy)) timeSampling(batch);
+            else batch();
+        }
+        template <typename Sampling>
+        void timeSampling(Sampling &&sampling, size_t scale = 1, nanosec overhead = nanosec { 0 })
+        {
+            auto start = SteadyClock::now();
+            auto frameWork = m_frameWork;
+            sampling();
+            m_counters.sampling += (SteadyClock::now() - start - (m_frameWork - frameWork)
+                - overhead) * static_cast<int64_t>(scale);
+        }
+        static nanosec measureClockOverhead();
+        void publishCounters();
         void setupMode_VGA_640x480_60Hz();
-        static TimingInfoBitfield checkSignalTiming(
-            bool sync, bool isBlack, nanosec t, nanosec syncPulse, nanosec backPorch,
-            nanosec visibleArea, nanosec frontPorch, double tolerance);
+        template <CheckPolicy policy>
+        void selectPolicy();
+        template <CheckPolicy policy>
+        void countedEval(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+                std::chrono::nanoseconds elapsed);
+        template <CheckPolicy policy>
+        void countedClock(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue);
+        template <CheckPolicy policy>
+        void countedChange(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+                std::chrono::nanoseconds hold);
+        template <CheckPolicy policy>
+        void evalWithPolicy(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+                std::chrono::nanoseconds elapsed);
+        template <CheckPolicy policy>
+        void clockWithPolicy(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue);
+        template <CheckPolicy policy>
+        void clockBatchWithPolicy(const uint16_t *samples, size_t count);
+        template <CheckPolicy policy>
+        void runWithPolicy(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+                size_t count);
+        template <CheckPolicy policy>
+        void clockRunsWithPolicy(const uint32_t *runs, size_t count);
+        template <CheckPolicy policy>
+        void changeWithPolicy(bool hSync, bool vSync, uint8_t red, uint8_t green, uint8_t blue,
+                std::chrono::nanoseconds hold);
+        template <bool collectStatistics>
+        void startFrame();
+        void startLine();
+        template <bool collectStatistics>
+        bool mergeTimingInfo(TimingInfoBitfield &hTimingInfo, TimingInfoBitfield &vTimingInfo);
+        template <bool collectStatistics>
+        void mergeSpanTimingInfo(TimingInfoBitfield hTimingInfo, TimingInfoBitfield vTimingInfo,
+                size_t h0, size_t h1, size_t v0, size_t v1, const PhaseRanges &hRanges,
+                const PhaseRanges &vRanges, size_t unit);
+        void updatePhaseRanges();
+        static void countViolations(TimingInfoBitfield timingInfo, std::array<size_t, 7> &counts);
+        void reportViolations(TimingInfoBitfield hTimingInfo, TimingInfoBitfield vTimingInfo,
+                size_t pixel);
+        void reportViolations(bool horizontal, TimingInfoBitfield timingInfo, size_t pixel);
+        bool presentFrame();
         void showTimingInfo(TimingInfoBitfield hTimingInfo, TimingInfoBitfield vTimingInfo);
+        void showFrameHistory();
 
         // members
+        CheckPolicy m_checkPolicy { CheckPolicy::FULL };
+        EvalFunc m_evalPolicy { nullptr };
+        ClockFunc m_clockPolicy { nullptr };
+        ClockBatchFunc m_clockBatchPolicy { nullptr };
+        ClockRunsFunc m_clockRunsPolicy { nullptr };
+        EvalFunc m_changePolicy { nullptr };
         Mode m_mode { Mode::VGA_640x480_60Hz };
         ColorDepth m_depth { ColorDepth::RGB_3BitPerColor };
+        Display m_display { Display::WINDOW };
+        bool m_windowSetup { false };
         State m_state { State::OUT_OF_SYNC };
         nanosec m_pixel { 0 };
         nanosec m_hSyncPulse { 0 };
@@ -91,6 +401,13 @@ class CVgaMonitor
         nanosec m_vVisibleArea { 0 };
         nanosec m_vFrontPorch { 0 };
         nanosec m_frame { 0 };
+        AxisTiming m_hPixels;
+        AxisTiming m_vLines;
+        size_t m_pixelsPerLine { 0 };
+        PhaseRanges m_hRanges;
+        PhaseRanges m_vRanges;
+        PhaseRanges m_hTimeRanges;
+        PhaseRanges m_vTimeRanges;
         double m_tolerance { 0.005 };
         size_t m_numPixels { 0 };
         size_t m_winWidth { 0 };
@@ -98,6 +415,53 @@ class CVgaMonitor
         uint8_t m_colorBitOffset { 0 };
 
         bool m_showTimingInfo { false };
+        bool m_vSync { true };
+
+        EventPumping m_eventPumping { EventPumping::PER_FRAME };
+        std::chrono::milliseconds m_eventInterval { 20 };
+        std::chrono::steady_clock::time_point m_nextEventPump;
+        std::atomic<bool> m_quitRequested { false };
+        std::atomic<bool> m_pauseRequested { false };
+
+        // sampling state
+        nanosec m_th { 0 };
+        nanosec m_tv { 0 };
+        bool m_hSyncLast { false };
+        bool m_vSyncLast { false };
+        size_t m_hPixel { 0 };          // pixels since the last hsync, when pixel clocked
+        size_t m_vPixel { 0 };          // pixels since the last vsync, when pixel clocked
+        size_t m_vLine { 0 };           // lines since the last vsync, when pixel clocked
+        size_t m_vLinePixel { 0 };
+        TimingInfoBitfield m_hTimingInfo { 0 };
+        TimingInfoBitfield m_vTimingInfo { 0 };
+        TimingStatistics m_statistics;
+        FrameCallback m_frameCallback;
+        size_t m_frameCount { 0 };
+        size_t m_lineCount { 0 };
+
+        // strict mode
+        bool m_strictMode { false };
+        size_t m_maxViolations { 1 };
+        size_t m_warmupFrames { 1 };
+        ViolationCallback m_violationCallback;
+        size_t m_violationCount { 0 };
+        TimingViolation m_firstViolation;
+        bool m_timingFailure { false };
+
+        // performance counters, published under the mutex
+        PerformanceCounters m_counters;
+        nanosec m_frameWork { 0 };      // spent in frame starts, taken out of the sampling time
+        PerformanceCounters m_publishedCounters;
+        mutable std::mutex m_countersMutex;
+
+        // profiler phase marker, the monitor's own one unless one is set
+        std::atomic<uint8_t> m_ownPhaseMarker { 0 };
+        std::atomic<uint8_t> *m_phaseMarker { &m_ownPhaseMarker };
+        uint8_t m_phaseBase { 0 };
+
+        static const char *s_phaseNames[7];
+        static const uint8_t s_phaseOfBit[7];   // the timing phase each TimingInfoBits checks
+        static const nanosec s_clockOverhead;   // of timing with two steady clock reads
 
         using windowPtr = std::unique_ptr<SDL_Window, decltype(&SDL_DestroyWindow)>;
         windowPtr m_window { nullptr, SDL_DestroyWindow };
@@ -107,5 +471,12 @@ class CVgaMonitor
         texturePtr m_texture { nullptr, SDL_DestroyTexture };
 
         std::vector<Pixel> m_buffer;
+
+        // frame history, a frame selected in the window is shown instead of the live one
+        std::unique_ptr<CFrameHistory> m_history;
+        bool m_historyLive { true };
+        size_t m_historyFrame { 0 };
+        size_t m_decodedFrame { SIZE_MAX };
+        std::vector<uint32_t> m_decodedPixels;
 };
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <ostream>
+
+#include "CPeripheral.hpp"
+#include "CPinBinding.hpp"
+#include "CVgaMonitor.hpp"
+
+// A CVgaMonitor as a peripheral of a scheduler, sampling the vga outputs of a top through a
+// CPinGroup with the inputs in the order of Input. With a zero half period it samples once
+// per rising edge of the pixel clock with clockPixel(), otherwise on both edges with eval()
+// and the half period as the elapsed time.
+template <typename Binding, typename Top>
+class CVgaMonitorPeripheral : public CPeripheral<CVgaMonitorPeripheral<Binding, Top>>
+{
+    public:
+        // types
+        enum Input
+        {
+            HSYNC, VSYNC, RED, GREEN, BLUE
+        };
+
+        static_assert((Binding::template Member<HSYNC>::width == 1)
+                && (Binding::template Member<VSYNC>::width == 1), "single bit syncs");
+        static_assert((Binding::template Member<RED>::width <= 8)
+                && (Binding::template Member<GREEN>::width <= 8)
+                && (Binding::template Member<BLUE>::width <= 8), "up to 8 bits per color");
+
+        // methods
+        CVgaMonitorPeripheral(CVgaMonitor &monitor, const Top &top,
+                std::chrono::nanoseconds halfPeriod = std::chrono::nanoseconds { 0 })
+            : m_monitor { monitor }, m_top { top }, m_halfPeriod { halfPeriod }
+        {
+        }
+
+        CVgaMonitor &getMonitor() { return m_monitor; }
+
+        void posedge()
+        {
+            if (m_halfPeriod.count() == 0)
+            {
+                m_monitor.clockPixel(get<HSYNC>(), get<VSYNC>(), get<RED>(), get<GREEN>(),
+                        get<BLUE>());
+            }
+            else negedge();
+        }
+
+        void negedge()
+        {
+            if (m_halfPeriod.count() == 0) return;
+
+            m_monitor.eval(get<HSYNC>(), get<VSYNC>(), get<RED>(), get<GREEN>(), get<BLUE>(),
+                    m_halfPeriod);
+        }
+
+        bool isFinished() const
+        {
+            return m_monitor.hasQuitEvent() || m_monitor.hasTimingFailure();
+        }
+
+        void printStats(std::ostream &os) const
+        {
+            auto counters = m_monitor.getPerformanceCounters();
+            os << "vga monitor: " << counters.frames << " frames, " << counters.framesDisplayed
+                << " shown, " << counters.violations << " violations, "
+                << m_monitor.getViolationCount() << " reported\n";
+        }
+
+    private:
+        // methods
+        template <Input input>
+        uint8_t get() const
+        {
+            return static_cast<uint8_t>(Binding::template get<input>(m_top));
+        }
+
+        // members
+        CVgaMonitor &m_monitor;
+        const Top &m_top;
+        std::chrono::nanoseconds m_halfPeriod;
+};
+
+template <typename Binding, typename Top>
+inline CVgaMonitorPeripheral<Binding, Top> makeVgaMonitorPeripheral(CVgaMonitor &monitor,
+        const Top &top, std::chrono::nanoseconds halfPeriod = std::chrono::nanoseconds { 0 })
+{
+    return { monitor, top, halfPeriod };
+}